@@ -4,10 +4,10 @@ layout(location=1) in vec3 normal;
 layout(location=2) in vec2 texcoord;
 
 // uniform variables
-uniform mat4	model_matrix;	// 4x4 transformation matrix: explained later in the lecture
+uniform mat4x3	model_matrix;	// affine 3x4 transformation matrix (row-major upload with transpose)
 uniform mat4	aspect_matrix;	// tricky 4x4 aspect-correction matrix
 
 void main()
 {
-	gl_Position = aspect_matrix*model_matrix*vec4(position,1);//aspect_matrix    
+	gl_Position = aspect_matrix*vec4(model_matrix*vec4(position,1),1);//aspect_matrix    
 }
\ No newline at end of file
@@ -100,11 +100,51 @@ struct mem_t
 	size_t	size = 0;
 };
 
+// vertex layout interpreted by cg_create_vertex_array(): attribute k binds to layout(location=k)
+struct vertex_attrib
+{
+	GLint		size;		// number of components
+	GLenum		type;		// GL_FLOAT, GL_SHORT, GL_UNSIGNED_SHORT, ...
+	GLboolean	normalized;	// integers map to [-1,1] (signed) or [0,1] (unsigned)
+	size_t		offset;		// byte offset in a vertex
+};
+
+struct vertex_format
+{
+	GLsizei						stride;
+	std::vector<vertex_attrib>	attribs;
+};
+
 struct vertex // will be used for all the course examples
 {
     vec3 pos;	// position
 	vec3 norm;	// normal vector; we will use this for vertex color for this example
     vec2 tex;	// texture coordinate; ignore this for the moment
+
+	static vertex_format format(){ return { sizeof(vertex), { {3,GL_FLOAT,GL_FALSE,offsetof(vertex,pos)}, {3,GL_FLOAT,GL_FALSE,offsetof(vertex,norm)}, {2,GL_FLOAT,GL_FALSE,offsetof(vertex,tex)} } }; }
+};
+
+// 16-byte vertex for meshes within the unit cube (scale them by the model matrix)
+// - pos: snorm16x4 with w=1; norm: octahedral snorm16x2 (decode in the shader); tex: unorm16x2
+struct compact_vertex
+{
+	short	pos[4];
+	short	norm[2];
+	ushort	tex[2];
+
+	static short snorm16( float f ){ return short(round(clamp(f,-1.0f,1.0f)*32767.0f)); }
+	static ushort unorm16( float f ){ return ushort(round(clamp(f,0.0f,1.0f)*65535.0f)); }
+
+	compact_vertex() = default;
+	explicit compact_vertex( const vertex& v )
+	{
+		vec2 n = oct_encode(v.norm.normalize());
+		pos[0]=snorm16(v.pos.x); pos[1]=snorm16(v.pos.y); pos[2]=snorm16(v.pos.z); pos[3]=32767;
+		norm[0]=snorm16(n.x); norm[1]=snorm16(n.y);
+		tex[0]=unorm16(v.tex.x); tex[1]=unorm16(v.tex.y);
+	}
+
+	static vertex_format format(){ return { sizeof(compact_vertex), { {4,GL_SHORT,GL_TRUE,offsetof(compact_vertex,pos)}, {2,GL_SHORT,GL_TRUE,offsetof(compact_vertex,norm)}, {2,GL_UNSIGNED_SHORT,GL_TRUE,offsetof(compact_vertex,tex)} } }; }
 };
 
 struct image
@@ -474,7 +514,7 @@ inline GLuint cg_create_program( const char* vert_path, const char* frag_path )
 	return program;
 }
 
-inline uint cg_create_vertex_array( uint vertex_buffer, uint index_buffer=0 )
+inline uint cg_create_vertex_array( uint vertex_buffer, uint index_buffer=0, const vertex_format& format=vertex::format() )
 {
 	if(!vertex_buffer){ printf("%s(): vertex_buffer == 0\n", __func__ ); return 0; }
 
@@ -487,14 +527,14 @@ inline uint cg_create_vertex_array( uint vertex_buffer, uint index_buffer=0 )
 	glBindBuffer( GL_ARRAY_BUFFER, vertex_buffer );
 	if(index_buffer) glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, index_buffer );
 
-	// bind vertex attributes by interpreting the organization of struct vertex
-	static size_t attrib_size[] = { sizeof(vertex().pos), sizeof(vertex().norm), sizeof(vertex().tex) };
-	for( size_t k=0, byte_offset=0; k<3; k++, byte_offset+=attrib_size[k-1] )
+	// bind vertex attributes by interpreting the vertex format (struct vertex by default)
+	for( size_t k=0; k < format.attribs.size(); k++ )
 	{
 		// We need to indicate the explicit binding of vertex attributes in vertex shader:
 		// e.g., layout(location=0) in vec3 position;
+		const vertex_attrib& a = format.attribs[k];
 		glEnableVertexAttribArray( GLuint(k) );
-		glVertexAttribPointer( GLuint(k), attrib_size[k]/sizeof(GLfloat), GL_FLOAT, GL_FALSE, sizeof(vertex), (GLvoid*) byte_offset );
+		glVertexAttribPointer( GLuint(k), a.size, a.type, a.normalized, format.stride, (GLvoid*) a.offset );
 	}
 
 	// unbind vao and return
@@ -502,7 +542,43 @@ inline uint cg_create_vertex_array( uint vertex_buffer, uint index_buffer=0 )
 	return vao;
 }
 
-inline mesh* cg_load_mesh( const char* vert_binary_path, const char* index_binary_path )
+// binds per-instance attributes (divisor 1) from layout(location=first_location) on
+// - first_instance offsets the attributes, which serves as the base instance missing before GL 4.2
+// - the vertex array object is left bound for drawing
+inline void cg_bind_instance_attributes( uint vao, uint instance_buffer, const vertex_format& format, uint first_location, size_t first_instance=0 )
+{
+	glBindVertexArray( vao );
+	glBindBuffer( GL_ARRAY_BUFFER, instance_buffer );
+	for( size_t k=0; k < format.attribs.size(); k++ )
+	{
+		const vertex_attrib& a = format.attribs[k];
+		GLuint location = GLuint(first_location+k);
+		glEnableVertexAttribArray( location );
+		glVertexAttribPointer( location, a.size, a.type, a.normalized, format.stride, (GLvoid*)(a.offset+first_instance*format.stride) );
+		glVertexAttribDivisor( location, 1 );
+	}
+}
+
+// binds a uniform block of the program to a binding point, which glBindBufferRange(GL_UNIFORM_BUFFER,binding,...)
+// fills; GLSL 3.30 lacks layout(binding=k), so the pairing is made here after linking
+inline bool cg_bind_uniform_block( GLuint program, const char* block_name, GLuint binding )
+{
+	GLuint index = glGetUniformBlockIndex( program, block_name );
+	if(index==GL_INVALID_INDEX){ printf( "%s(): uniform block %s not found\n", __func__, block_name ); return false; }
+	glUniformBlockBinding( program, index, binding );
+	return true;
+}
+
+// rounds up a size to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, so ranges packed in one buffer can be bound by glBindBufferRange()
+inline size_t cg_uniform_buffer_align( size_t size )
+{
+	static GLint alignment = 0; if(!alignment) glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment );
+	size_t a = alignment>0 ? size_t(alignment) : 256;
+	return (size+a-1)/a*a;
+}
+
+// optimize: optional reordering before the upload, e.g., optimize_mesh<vertex> of meshopt.h
+inline mesh* cg_load_mesh( const char* vert_binary_path, const char* index_binary_path, void(*optimize)(std::vector<vertex>&,std::vector<uint>&)=nullptr )
 {
 	mesh* new_mesh = new mesh();
 
@@ -515,13 +591,16 @@ inline mesh* cg_load_mesh( const char* vert_binary_path, const char* index_binar
 	// load index buffer
 	mem_t i = cg_read_binary(index_binary_path);
 	if(i.size%sizeof(uint)){ printf( "%s is not a valid index binary file\n", index_binary_path ); return nullptr; }
-	new_mesh->index_list.resize( v.size/sizeof(uint) );
+	new_mesh->index_list.resize( i.size/sizeof(uint) );
 	memcpy( (void*)&new_mesh->index_list[0], i.ptr, i.size );
 
 	// release memory
 	if(v.ptr) free(v.ptr);
 	if(i.ptr) free(i.ptr);
 
+	// reorder vertices and indices
+	if(optimize) optimize( new_mesh->vertex_list, new_mesh->index_list );
+
 	// create a vertex buffer
 	glGenBuffers( 1, &new_mesh->vertex_buffer );
 	glBindBuffer( GL_ARRAY_BUFFER, new_mesh->vertex_buffer );
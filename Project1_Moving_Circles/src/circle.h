@@ -9,10 +9,11 @@ struct circle_t
 	float	velocity = 1.0f;
 	float	theta = 0.0f;		//movement direction 
 	vec4	color;				// RGBA color in [0,1]
-	mat4	model_matrix;		// modeling transformation
+	mat4x3	model_matrix;		// modeling transformation (affine)
 
 	// public functions
-	void	update();	
+	void	update();			// moves by one step, and updates the model matrix
+	void	update_matrix();	
 };
 
 float getDistance(vec2 a, vec2 b) {
@@ -53,6 +54,7 @@ inline std::vector<circle_t> create_circles(uint N)
 			continue;
 		}
 			
+		c.update_matrix();	// drawable before its first step
 		circles.emplace_back(c);
 	}
 	
@@ -64,30 +66,31 @@ inline void circle_t::update()
 	float c	= cos(theta), s=sin(theta);
 	center.x = center.x + velocity * c;
 	center.y = center.y + velocity * s;
+	update_matrix();
+}
 
+inline void circle_t::update_matrix()
+{
 	// these transformations will be explained in later transformation lecture
-	mat4 scale_matrix =
+	mat4x3 scale_matrix =
 	{
 		radius, 0, 0, 0,
 		0, radius, 0, 0,
-		0, 0, 1, 0,
-		0, 0, 0, 1
+		0, 0, 1, 0
 	};
 
-	mat4 rotation_matrix =
+	mat4x3 rotation_matrix =
 	{
 		1, 0, 0, 0,
 		0, 1, 0, 0,
-		0, 0, 1, 0,
-		0, 0, 0, 1
+		0, 0, 1, 0
 	};
 
-	mat4 translate_matrix =
+	mat4x3 translate_matrix =
 	{
 		1, 0, 0, center.x,
 		0, 1, 0, center.y,
-		0, 0, 1, 0,
-		0, 0, 0, 1
+		0, 0, 1, 0
 	};
 	
 	model_matrix = translate_matrix * rotation_matrix * scale_matrix;
@@ -1,6 +1,7 @@
 #include "cgmath.h"		// slee's simple math library
 #include "cgut.h"		// slee's OpenGL utility
 #include "circle.h"		// circle class definition
+#include "simclock.h"	// simulation clock
 
 //*************************************
 // global constants
@@ -11,6 +12,8 @@ static const uint	MIN_CIRCLE = 20;	// minimum number of circle
 static const uint	MAX_CIRCLE = 512;	// maximum number of circle
 uint				NUM_CIRCLE = 25;	// initial number of circle
 uint				NUM_TESS = 36;		// initial tessellation factor of the circle as a polygon
+static const double	STEP_DT = 1.0/60.0;	// simulation seconds of a step; the velocities of circles are per step
+static const uint	MAX_STEPS = 16;		// most steps per frame at large time scales
 
 //*************************************
 // window objects
@@ -25,7 +28,7 @@ GLuint	vertex_array = 0;	// ID holder for vertex array object
 //*************************************
 // global variables
 int		frame = 0;						// index of rendering frames
-float	t = 0.0f;						// current simulation parameter
+sim_clock	sim;						// simulation clock
 bool	b_solid_color = false;			// use circle's color?
 bool	b_index_buffer = true;			// use index buffering?
 #ifndef GL_ES_VERSION_2_0
@@ -95,8 +98,10 @@ void elasticCollision(circle_t &c1, circle_t &c2) {
 //*************************************
 void update()
 {
-	// update global simulation parameter
-	t = float(glfwGetTime())*0.4f;
+	// advance the simulation clock, and the circles in fixed steps
+	void step_circles(); // forward declaration
+	sim.tick(glfwGetTime());
+	for (uint k = sim.steps(STEP_DT, MAX_STEPS); k; k--) step_circles();
 
 	// tricky aspect correction matrix for non-square window
 	float aspect = window_size.x/float(window_size.y);
@@ -120,18 +125,10 @@ void update()
 	//if(b) update_tess(); 
 }
 
-void render()
+//*************************************
+// one fixed step of the circles: move, bounce off the walls, and collide
+void step_circles()
 {
-	// clear screen (with background color) and clear depth buffer
-	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-
-	// notify GL that we use our own program
-	glUseProgram( program );
-
-	// bind vertex array object
-	glBindVertexArray( vertex_array );
-
-	// render circles: trigger shader program to process vertex data
 	for(auto& c : circles)
 	{
 		// per-circle update
@@ -170,11 +167,27 @@ void render()
 				elasticCollision(c, tmp);
 			}
 		}
+	}
+}
 
+void render()
+{
+	// clear screen (with background color) and clear depth buffer
+	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+
+	// notify GL that we use our own program
+	glUseProgram( program );
+
+	// bind vertex array object
+	glBindVertexArray( vertex_array );
+
+	// render circles: trigger shader program to process vertex data
+	for(auto& c : circles)
+	{
 		// update per-circle uniforms
 		GLint uloc;
 		uloc = glGetUniformLocation( program, "solid_color" );		if(uloc>-1) glUniform4fv( uloc, 1, c.color );	// pointer version
-		uloc = glGetUniformLocation( program, "model_matrix" );		if(uloc>-1) glUniformMatrix4fv( uloc, 1, GL_TRUE, c.model_matrix );
+		uloc = glGetUniformLocation( program, "model_matrix" );		if(uloc>-1) glUniformMatrix4x3fv( uloc, 1, GL_TRUE, c.model_matrix );
 
 		// per-circle draw calls
 		if(b_index_buffer)	glDrawElements( GL_TRIANGLES, NUM_TESS*3, GL_UNSIGNED_INT, nullptr );
@@ -200,6 +213,9 @@ void print_help()
 	printf( "- press F1 or 'h' to see help\n" );
 	printf( "- press '+/-' to increase/decrease circle number (min=%d, max=%d)\n", MIN_CIRCLE, MAX_CIRCLE );
 	printf( "- press 'i' to toggle between index buffering and simple vertex buffering\n" );
+	printf( "- press SPACE to pause/resume the simulation\n" );
+	printf( "- press ',/.' to slow down/speed up the simulation by 10x (x%g to x%g)\n", sim_clock::MIN_SCALE, sim.max_scale );
+	printf( "- press '/' to advance the simulation by one frame while paused\n" );
 #ifndef GL_ES_VERSION_2_0
 	printf( "- press 'w' to toggle wireframe\n" );
 #endif
@@ -296,6 +312,20 @@ void keyboard( GLFWwindow* window, int key, int scancode, int action, int mods )
 			b.sub = true;
 			update_circles();
 		}
+		else if(key==GLFW_KEY_SPACE)
+		{
+			sim.pause( !sim.paused );
+			printf( "> simulation %s at %.2f s (%.2f s dropped beyond %u steps per frame)\n", sim.paused?"paused":"resumed", sim.time, sim.dropped, MAX_STEPS );
+		}
+		else if(key==GLFW_KEY_COMMA||key==GLFW_KEY_PERIOD)
+		{
+			sim.set_scale( key==GLFW_KEY_PERIOD ? sim.scale*10 : sim.scale/10 );
+			printf( "> time scale x%g (at most x%g)\n", sim.scale, sim.max_scale );
+		}
+		else if(key==GLFW_KEY_SLASH)
+		{
+			sim.step_once();
+		}
 		else if(key==GLFW_KEY_I)
 		{
 			b_index_buffer = !b_index_buffer;
@@ -333,6 +363,9 @@ void motion( GLFWwindow* window, double x, double y )
 
 bool user_init()
 {
+	// the circles advance only in steps, so faster scales than MAX_STEPS per frame would drop time
+	sim.limit_scale( sim_clock::reachable_scale( STEP_DT, MAX_STEPS ) );
+
 	// log hotkeys
 	print_help();
 
@@ -1,22 +1,51 @@
 // vertex attributes
 layout(location=0) in vec3 position;
-layout(location=1) in vec3 normal;
+layout(location=1) in vec2 normal;	// octahedral encoding
 layout(location=2) in vec2 texcoord;
 
 // matrices
-uniform mat4 model_matrix;
+uniform mat4x3 model_matrix;	// affine 3x4 (row-major upload with transpose)
 uniform mat4 view_projection_matrix;
 uniform mat4 aspect_matrix;
 
 //out vec3 norm;
 out vec2 tc;
 
+// procedural uv sphere: the same grid and triangle order as create_sphere_indices(),
+// but every vertex is computed from gl_VertexID, so no vertex or index buffer is bound
+uniform bool b_procedural;
+uniform int tess;	// tessellation factor N: N segments and N/2 rings
+
+void sphere_vertex( out vec3 p, out vec3 n, out vec2 t )
+{
+	const int di[6] = int[6]( 0, 0, 1, 0, 1, 1 );	// segment offsets of the six corners of a cell
+	const int dj[6] = int[6]( 0, 1, 1, 0, 1, 0 );	// ring offsets
+	int cell = gl_VertexID/6, corner = gl_VertexID-cell*6, rings = tess/2;
+	int i = cell/rings+di[corner], j = cell-(cell/rings)*rings+dj[corner];
+
+	float theta = 6.2831853*float(j)/float(tess), phi = 6.2831853*float(i)/float(tess);
+	float ct = cos(theta), st = sin(theta), cp = cos(phi), sp = sin(phi);
+	n = vec3(st*cp, st*sp, ct);
+	p = n;
+	t = vec2(phi/6.2831853, 1.0-theta/3.1415927);
+}
+
+vec3 oct_decode( vec2 e )
+{
+	vec3 n = vec3(e, 1.0-abs(e.x)-abs(e.y));
+	if(n.z<0.0) n.xy = (1.0-abs(e.yx))*vec2(e.x>=0.0?1.0:-1.0, e.y>=0.0?1.0:-1.0);
+	return normalize(n);
+}
+
 void main()
 {
-	vec4 pos_in_hc = vec4(position, 1);//local frame
-	vec4 wpos = model_matrix * pos_in_hc;//world frame
+	vec3 p = position, n = oct_decode(normal); vec2 t = texcoord;
+	if(b_procedural) sphere_vertex(p, n, t);
+
+	vec4 pos_in_hc = vec4(p, 1);//local frame
+	vec4 wpos = vec4(model_matrix * pos_in_hc, 1);//world frame
 	gl_Position = aspect_matrix * view_projection_matrix * wpos;//NDC or canonical view volume [-1,1]
 
 	// pass eye-coordinate normal to fragment shader
-	tc = texcoord;
+	tc = t;
 }
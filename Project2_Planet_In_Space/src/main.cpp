@@ -1,21 +1,31 @@
+#include <condition_variable>	// include before cgmath.h, which defines min/max macros
+#include <thread>
 #include "cgmath.h"		// slee's simple math library
 #include "cgut.h"		// slee's OpenGL utility
+#include "sphere.h"		// sphere tessellation
+#include "meshopt.h"	// vertex cache/fetch optimization
+#include "meshcache.h"	// mesh cache on disk
+#include "spsc.h"		// lock-free queue between threads
+#include "simclock.h"	// simulation clock
 
 //*************************************
 // global constants
 static const char*	window_name = "Project 2 - Planet in Space";
 static const char*	vert_shader_path = "../bin/shaders/project2.vert";
 static const char*	frag_shader_path = "../bin/shaders/project2.frag";
+static const char*	mesh_cache_dir = "../bin/cache";
 float				MAX_RADIUS = 1;
 float				MIN_RADIUS = 0.1f;
 float				SIZE_RADIUS = 1;
 uint				NUM_TESS = 72;		// initial tessellation factor of the circle as a polygon
+uint				MIN_TESS = 8;
+uint				MAX_TESS = 512;
 
 //*************************************
 // window objects
 GLFWwindow*	window = nullptr;
 ivec2		window_size = ivec2(1280, 720); // initial window size
-GLuint		vertex_array = 0;	// ID holder for vertex array object
+GLuint		empty_vertex_array = 0;	// no attributes: the procedural sphere is computed from gl_VertexID
 
 //*************************************
 // OpenGL objects
@@ -26,29 +36,15 @@ GLuint	program	= 0;	// ID holder for GPU program
 int		frame = 0;		// index of rendering frames
 int		visualization = 0; //for text coordination visualization
 
-//time parameters to control the rotation
-float	xf_stop_time = 0;
-float	xf_blank_time = 0;
-float	xr_stop_time = 0;
-float	xr_blank_time = 0;
-float	yf_stop_time = 0;
-float	yf_blank_time = 0;
-float	yr_stop_time = 0;
-float	yr_blank_time = 0;
-float	zf_stop_time = 0;
-float	zf_blank_time = 0;
-float	zr_stop_time = 0;
-float	zr_blank_time = 0;
+sim_clock	sim;	// simulation clock
 
-bool	b_wireframe = false;
+//orientation of the sphere, integrated from the angular velocity toggled by the keys
+quat	orientation;
+vec3	spin = vec3(0);	// radians per second about the world x, y, and z axes
 
-//bool parameters for checking the rotation
-bool	xf_rotate = false;
-bool	xr_rotate = false;
-bool	yf_rotate = false;
-bool	yr_rotate = false;
-bool	zf_rotate = false;
-bool	zr_rotate = false;
+bool	b_wireframe = false;
+bool	b_strip = false;	// draw triangle strips with primitive restart instead of triangle lists
+bool	b_procedural = false;	// generate the sphere in the vertex shader without vertex/index buffers
 
 struct {
 	bool add = false, sub = false;
@@ -57,44 +53,48 @@ struct {
 
 //*************************************
 // scene objects
-std::vector<vertex> unit_sphere_vertices;
 
-//*************************************
-int is_rotate() {//function to find the direction of rotation
-	if (xf_rotate)
-		return 1;
-	else if (xr_rotate)
-		return 2;
-	else if (yf_rotate)
-		return 3;
-	else if (yr_rotate)
-		return 4;
-	else if (zf_rotate)
-		return 5;
-	else if (zr_rotate)
-		return 6;
-	return 0;
-}
-
-char return_char(int flag) {//function to return the alphabet for help
-	switch (flag) {
-	case 1:
-		return 'f';
-	case 2:
-		return 'g';
-	case 3:
-		return 'v';
-	case 4:
-		return 'b';
-	case 5:
-		return 'r';
-	case 6:
-		return 't';
-	default:
-		return 'x';
-	}
-}
+// vertex/index blobs of a sphere built on the worker thread: owned, or mapped from the mesh cache
+struct sphere_build
+{
+	uint				N = 0;
+	size_t				list_index_count = 0, strip_index_count = 0;
+	std::vector<compact_vertex>	vertices;
+	std::vector<uint>	indices;
+	std::vector<ushort>	indices16;	// when every vertex is addressable below the restart index
+	mesh_cache_file		cache;
+	mesh_data			data;		// points into vertices/indices or into the mapped cache
+	double				build_ms = 0;
+};
+
+// GPU buffers of a sphere; the index buffer holds the list and then the strips
+struct sphere_buffers
+{
+	GLuint	vertex_buffer = 0;	// ID holder for vertex buffer
+	GLuint	index_buffer = 0;	// ID holder for index buffer
+	GLuint	vertex_array = 0;	// ID holder for vertex array object
+	GLenum	index_type = GL_UNSIGNED_INT;	// GL_UNSIGNED_SHORT for spheres of up to 65535 vertices
+	uint	N = 0;
+	size_t	list_index_count = 0, strip_index_count = 0;
+};
+
+// double-buffered: render() draws the front set, while a finished build is uploaded into the back
+// set; the sets swap only after the upload, so a tessellation change never shows a partial mesh
+sphere_buffers	sphere_sets[2];
+int				front = 0;
+
+// the worker thread builds the latest requested tessellation and hands it back through a lock-free queue
+struct
+{
+	std::thread							thread;
+	std::atomic<uint>					requested{0};	// latest tessellation; older requests are dropped
+	std::atomic<bool>					quit{false};
+	std::mutex							mutex;			// only for sleeping/waking the worker
+	std::condition_variable				wake;
+	spsc_queue<sphere_build*,4>			results;		// worker to render thread
+} worker;
 
+//*************************************
 void update()
 {
 	// update projection matrix
@@ -120,10 +120,20 @@ void update()
 	uloc = glGetUniformLocation(program, "view_projection_matrix");			if(uloc > -1) glUniformMatrix4fv(uloc, 1, GL_TRUE, view_projection_matrix);		
 	uloc = glGetUniformLocation(program, "aspect_matrix");					if(uloc > -1) glUniformMatrix4fv(uloc, 1, GL_TRUE, aspect_matrix);
 	uloc = glGetUniformLocation(program, "visualization");					if(uloc > -1) glUniform1i(uloc, visualization);
+	uloc = glGetUniformLocation(program, "b_procedural");					if(uloc > -1) glUniform1i(uloc, b_procedural);
+	uloc = glGetUniformLocation(program, "tess");							if(uloc > -1) glUniform1i(uloc, NUM_TESS);	// changing the tessellation is only a uniform update
 	
-	// update vertex buffer by the pressed keys
-	void update_tess(); // forward declaration
-	if (b) update_tess();
+	// advance the simulation clock, and the orientation by the angular velocity
+	sim.tick(glfwGetTime());
+	orientation.integrate(spin, sim.dt);
+
+	// update the radius by the pressed keys
+	void update_radius(); // forward declaration
+	if (b) update_radius();
+
+	// swap in the sphere finished by the worker thread, if any
+	void update_sphere(); // forward declaration
+	update_sphere();
 }
 
 void render()
@@ -134,27 +144,25 @@ void render()
 	// notify GL that we use our own program
 	glUseProgram( program );
 	
-	// bind vertex array object
-	glBindVertexArray(vertex_array);
+	// bind vertex array object of the front set
+	const sphere_buffers& s = sphere_sets[front];
+	glBindVertexArray(b_procedural ? empty_vertex_array : s.vertex_array);
 	
 	// configure transformation parameters
-	float xft = xf_rotate ? float(glfwGetTime()) - xf_blank_time : xf_stop_time - xf_blank_time;
-	float xrt = xr_rotate ? float(glfwGetTime()) - xr_blank_time : xr_stop_time - xr_blank_time;
-
-	float yft = yf_rotate ? float(glfwGetTime()) - yf_blank_time : yf_stop_time - yf_blank_time;
-	float yrt = yr_rotate ? float(glfwGetTime()) - yr_blank_time : yr_stop_time - yr_blank_time;
-
-	float zft = zf_rotate ? float(glfwGetTime()) - zf_blank_time : zf_stop_time - zf_blank_time;
-	float zrt = zr_rotate ? float(glfwGetTime()) - zr_blank_time : zr_stop_time - zr_blank_time;
-
-	// build the model matrix
-	mat4 model_matrix = mat4::rotate(vec3(1, 0, 0), xft - xrt) *
-						mat4::rotate(vec3(0, 1, 0), yft - yrt) *
-						mat4::rotate(vec3(0, 0, 1), zft - zrt);
+	// build the model matrix: the radius is a uniform scale of the unit sphere
+	mat4x3 model_matrix = mat4x3(orientation) * mat4x3::scale(SIZE_RADIUS);
 
 	// update the uniform model matrix and render
-	glUniformMatrix4fv( glGetUniformLocation( program, "model_matrix" ), 1, GL_TRUE, model_matrix );
-	glDrawElements( GL_TRIANGLES, NUM_TESS * NUM_TESS * 3, GL_UNSIGNED_INT, nullptr );
+	glUniformMatrix4x3fv( glGetUniformLocation( program, "model_matrix" ), 1, GL_TRUE, model_matrix );	// affine 3x4 upload
+	if(b_procedural)	glDrawArrays( GL_TRIANGLES, 0, GLsizei(NUM_TESS * (NUM_TESS / 2) * 6) );
+	else if(b_strip)
+	{
+#ifndef GL_ES_VERSION_2_0
+		if(gl_version_t::instance().gl()<43) glPrimitiveRestartIndex( s.index_type == GL_UNSIGNED_SHORT ? 0xffff : SPHERE_RESTART_INDEX ); // no fixed index before GL 4.3
+#endif
+		glDrawElements( GL_TRIANGLE_STRIP, GLsizei(s.strip_index_count), s.index_type, (GLvoid*)(s.list_index_count * (s.index_type == GL_UNSIGNED_SHORT ? sizeof(ushort) : sizeof(uint))) );
+	}
+	else				glDrawElements( GL_TRIANGLES, GLsizei(s.list_index_count), s.index_type, nullptr );
 
 	// swap front and back buffers, and display to screen
 	glfwSwapBuffers( window );
@@ -174,85 +182,159 @@ void print_help()
 	printf( "- press ESC or 'q' to terminate the program\n" );
 	printf( "- press F1 or 'h' to see help\n" );
 	printf( "- press 'w' to toggle wireframe\n" );
+	printf( "- press 's' to toggle triangle strips and triangle lists\n" );
+	printf( "- press 'p' to toggle the procedural sphere without vertex buffers\n" );
 	printf( "- press 'd' to toggle (tc.xy,0) > (tc.xxx) > (tc.yyy)\n" );
 	printf( "- press '+/-' to increase/decrease the radius of the sphere\n" );
-	printf( "- press 'f' or 'g' to rotate the sphere on x axis\n");
-	printf( "- press 'v' or 'b' to rotate the sphere on y axis\n");
-	printf( "- press 'r' or 't' to rotate the sphere on z axis\n");
+	printf( "- press '[/]' to decrease/increase the tessellation of the sphere\n" );
+	printf( "- press 'f' or 'g' to start/stop rotating the sphere on x axis\n");
+	printf( "- press 'v' or 'b' to start/stop rotating the sphere on y axis\n");
+	printf( "- press 'r' or 't' to start/stop rotating the sphere on z axis\n");
+	printf( "  (the axes combine, e.g., 'f' and 'v' rotate on x and y at once)\n");
+	printf( "- press SPACE to pause/resume the simulation\n" );
+	printf( "- press ',/.' to slow down/speed up the simulation by 10x (x%g to x%g)\n", sim_clock::MIN_SCALE, sim.max_scale );
+	printf( "- press '/' to advance the simulation by one frame while paused\n" );
 	printf( "\n" );
 }
 
-std::vector<vertex> create_sphere_vertices(uint N)
+void update_vertex_buffer(sphere_buffers& s, const sphere_build& b)
 {
-	std::vector<vertex> v = { { vec3(0), vec3(0,0,-1.0f), vec2(0.5f) } };
-	for (uint i = 0; i <= N; i++)
-	{
-		for (uint j = 0; j <= N / 2; j++) 
-		{
-			float r = SIZE_RADIUS;
-			float t = PI * 2.0f * j / float(N), tc = cos(t), ts = sin(t);
-			float p = PI * 2.0f * i / float(N), pc = cos(p), ps = sin(p);
-			v.push_back({ vec3(r * ts * pc, r * ts * ps, r * tc), vec3(ts * pc, ts * ps, tc), vec2(p / (2.0f * PI), 1.0f - (t / PI)) });
-		}
-	}
-	return v;
+	// clear and create new buffers
+	if (s.vertex_buffer)	glDeleteBuffers(1, &s.vertex_buffer);	s.vertex_buffer = 0;
+	if (s.index_buffer)		glDeleteBuffers(1, &s.index_buffer);	s.index_buffer = 0;
+	if (s.vertex_array)		glDeleteVertexArrays(1, &s.vertex_array);
+	s.vertex_array = 0;
+	s.N = 0; s.list_index_count = s.strip_index_count = 0;
+
+	// check exceptions
+	const mesh_data& m = b.data;
+	if (!m.vertex_bytes) { printf("[error] vertices is empty.\n"); return; }
+	if (m.vertex_stride != sizeof(compact_vertex) || (m.index_size != sizeof(ushort) && m.index_size != sizeof(uint))) { printf("[error] unexpected vertex/index format.\n"); return; }
+
+	// unbind the vertex array object of the front set, which would otherwise capture the new index buffer
+	glBindVertexArray(0);
+
+	// generation of vertex buffer: compact vertices (16 bytes instead of 32 bytes), as they are
+	glGenBuffers(1, &s.vertex_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, s.vertex_buffer);
+	glBufferData(GL_ARRAY_BUFFER, m.vertex_bytes, m.vertices, GL_STATIC_DRAW);
+
+	// geneation of index buffer: 16-bit indices when every vertex is addressable
+	//GL_ELEMENT_ARRAY_BUFFER == INDEX_BUFFER
+	glGenBuffers(1, &s.index_buffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.index_buffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m.index_bytes, m.indices, GL_STATIC_DRAW);
+	s.index_type = m.index_size == sizeof(ushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	// generate vertex array object, which is mandatory for OpenGL 3.3 and higher
+	s.vertex_array = cg_create_vertex_array(s.vertex_buffer, s.index_buffer, compact_vertex::format());
+	if (!s.vertex_array) { printf("%s(): failed to create vertex aray\n", __func__); return; }
+	s.N = b.N; s.list_index_count = b.list_index_count; s.strip_index_count = b.strip_index_count;
 }
 
-void update_vertex_buffer(const std::vector<vertex>& vertices, uint N)
+// the sphere of N segments: mapped from the mesh cache, or generated and then stored
+// - the description holds every generator parameter; bump its version when the generator changes
+// - the aux blob holds the index counts of the list and the strips
+// - no GL calls, so that the worker thread can run it
+sphere_build* build_sphere(uint N)
 {
-	static GLuint vertex_buffer = 0;	// ID holder for vertex buffer
-	static GLuint index_buffer = 0;		// ID holder for index buffer
-
-	// clear and create new buffers
-	if (vertex_buffer)	glDeleteBuffers(1, &vertex_buffer);	vertex_buffer = 0;
-	if (index_buffer)	glDeleteBuffers(1, &index_buffer);	index_buffer = 0;
+	auto t0 = std::chrono::high_resolution_clock::now();
+	sphere_build* b = new sphere_build; b->N = N;
+	std::string desc = "project2 sphere v2: uv z_up, forsyth 32 + fetch, compact_vertex, 16-bit below 0xffff, list + strips, segments " + std::to_string(N);
+	std::string cache_path = mesh_cache_path(mesh_cache_dir, desc);
 
-	// check exceptions
-	if (vertices.empty()) { printf("[error] vertices is empty.\n"); return; }
+	// a hit is uploaded directly from the mapped file
+	if (b->cache.open(cache_path, desc) && b->cache.data().aux_bytes == sizeof(uint64_t) * 2)
+	{
+		const uint64_t* counts = (const uint64_t*)b->cache.data().aux;
+		b->list_index_count = size_t(counts[0]); b->strip_index_count = size_t(counts[1]);
+		b->data = b->cache.data();
+	}
+	else
+	{
+		b->cache.close();
+		std::vector<vertex> vertices = create_sphere_vertices(N);
+		std::vector<uint>& indices = b->indices = create_sphere_indices(N);
+		std::vector<uint> strip_indices = create_sphere_strip_indices(N);
+
+		// reorder triangles for the post-transform cache, and then vertices for the fetch;
+		// the strips follow the list in the same buffer, so they are renumbered together
+		optimize_vertex_cache(indices, vertices.size());
+		b->list_index_count = indices.size(); b->strip_index_count = strip_indices.size();
+		indices.insert(indices.end(), strip_indices.begin(), strip_indices.end());
+		optimize_vertex_fetch(vertices, indices);
+
+		// GPU-ready blobs: compact vertices, and 16-bit indices when every vertex is addressable;
+		// 0xffff is the restart index of 16-bit indices, and SPHERE_RESTART_INDEX truncates to it
+		std::vector<compact_vertex>& compact_vertices = b->vertices = std::vector<compact_vertex>(vertices.begin(), vertices.end());
+		if (vertices.size() <= 0xffff) b->indices16.assign(indices.begin(), indices.end());
+
+		uint64_t counts[2] = { b->list_index_count, b->strip_index_count };
+		mesh_data& m = b->data;
+		m.vertices = compact_vertices.data();	m.vertex_bytes = sizeof(compact_vertex) * compact_vertices.size();	m.vertex_stride = sizeof(compact_vertex);
+		if (!b->indices16.empty()) { m.indices = b->indices16.data(); m.index_bytes = sizeof(ushort) * b->indices16.size(); m.index_size = sizeof(ushort); }
+		else { m.indices = indices.data(); m.index_bytes = sizeof(uint) * indices.size(); m.index_size = sizeof(uint); }
+		m.aux = counts;					m.aux_bytes = sizeof(counts);
+		mesh_cache_store(cache_path, desc, m);
+		m.aux = nullptr;				m.aux_bytes = 0;	// counts goes out of scope
+	}
+	b->build_ms = std::chrono::duration<double,std::milli>(std::chrono::high_resolution_clock::now()-t0).count();
+	return b;
+}
 
-	// create buffers
-	std::vector<uint> indices;
-	for (uint i = 0; i < N; i++) 
+void worker_main()
+{
+	uint built = worker.requested.load();
+	while (true)
 	{
-		for (uint j = 0; j < N / 2; j++)
+		// sleep until a new tessellation is requested
+		uint N;
+		{
+			std::unique_lock<std::mutex> lock(worker.mutex);
+			worker.wake.wait(lock, [&]() { return worker.quit.load() || worker.requested.load() != built; });
+			if (worker.quit.load()) return;
+			N = built = worker.requested.load();
+		}
+
+		// hand the result over; the render thread drains the queue every frame
+		sphere_build* b = build_sphere(N);
+		while (!worker.results.push(b))
 		{
-			//set the order for front-facing, not back-facing
-			indices.push_back(i * (N / 2 + 1) + j + 1);
-			indices.push_back(i * (N / 2 + 1) + j + 2);
-			indices.push_back((i + 1) * (N / 2 + 1) + j + 2);
-
-			indices.push_back(i * (N / 2 + 1) + j + 1);	
-			indices.push_back((i + 1) * (N / 2 + 1) + j + 2);
-			indices.push_back((i + 1) * (N / 2 + 1) + j + 1);
+			if (worker.quit.load()) { delete b; return; }
+			std::this_thread::yield();
 		}
 	}
+}
 
-	// generation of vertex buffer: use vertices as it is
-	glGenBuffers(1, &vertex_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
+void request_sphere(uint N)
+{
+	worker.requested.store(N);
+	{ std::lock_guard<std::mutex> lock(worker.mutex); } // a worker between its check and wait() cannot miss the notification
+	worker.wake.notify_one();
+}
 
-	// geneation of index buffer
-	//GL_ELEMENT_ARRAY_BUFFER == INDEX_BUFFER
-	glGenBuffers(1, &index_buffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint) * indices.size(), &indices[0], GL_STATIC_DRAW);
-	
+// called every frame: uploads the latest finished build into the back set and swaps the sets
+void update_sphere()
+{
+	sphere_build* latest = nullptr;
+	for (sphere_build* b; worker.results.pop(b); ) { delete latest; latest = b; }
+	if (!latest) return;
 
-	// generate vertex array object, which is mandatory for OpenGL 3.3 and higher
-	if (vertex_array) glDeleteVertexArrays(1, &vertex_array);
-	vertex_array = cg_create_vertex_array(vertex_buffer, index_buffer);
-	if (!vertex_array) { printf("%s(): failed to create vertex aray\n", __func__); return; }
+	update_vertex_buffer(sphere_sets[1 - front], *latest);
+	if (sphere_sets[1 - front].vertex_array)
+	{
+		front = 1 - front;
+		printf("> sphere of %u segments is ready (%.1f ms on the worker thread)\n", latest->N, latest->build_ms);
+	}
+	delete latest;
 }
 
-void update_tess()
+void update_radius()
 {
 	float n = SIZE_RADIUS; if (b.add) n = n + 0.001f; if (b.sub) n = n - 0.001f;
 	if (n == SIZE_RADIUS || n<MIN_RADIUS || n>MAX_RADIUS) return;
 
-	SIZE_RADIUS = n;
-	unit_sphere_vertices = create_sphere_vertices(NUM_TESS);
-	update_vertex_buffer(unit_sphere_vertices, NUM_TESS);
+	SIZE_RADIUS = n;	// applied in render() as a model scale; no mesh or buffer update
 	printf("> SIZE_RADIUS = %.4f\n", SIZE_RADIUS);
 }
 
@@ -260,7 +342,6 @@ void keyboard( GLFWwindow* window, int key, int scancode, int action, int mods )
 {
 	if(action==GLFW_PRESS)
 	{
-		int flag = is_rotate();
 		if(key==GLFW_KEY_ESCAPE||key==GLFW_KEY_Q)	glfwSetWindowShouldClose( window, GL_TRUE );
 		else if(key==GLFW_KEY_H||key==GLFW_KEY_F1)	print_help();
 		else if (key == GLFW_KEY_KP_ADD || (key == GLFW_KEY_EQUAL && (mods & GLFW_MOD_SHIFT))) {
@@ -273,77 +354,47 @@ void keyboard( GLFWwindow* window, int key, int scancode, int action, int mods )
 			b.sub = true;
 			
 		}
-		else if (key == GLFW_KEY_R)
+		else if (key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET)
 		{
-			if (flag == 5 || flag == 0) {
-				if (zf_rotate)
-					zf_stop_time = float(glfwGetTime());
-				else
-					zf_blank_time += (float(glfwGetTime()) - zf_stop_time);
-				zf_rotate = !zf_rotate;
+			uint n = key == GLFW_KEY_RIGHT_BRACKET ? min(NUM_TESS + 8, MAX_TESS) : max(NUM_TESS - 8, MIN_TESS);
+			if (n != NUM_TESS)
+			{
+				NUM_TESS = n;			// the procedural sphere follows at once
+				request_sphere(n);		// the buffered sphere is swapped in when built
+				printf("> NUM_TESS = %u\n", NUM_TESS);
 			}
-			else 
-				printf("> Stop rotation first!(Press '%c' to stop)\n", return_char(flag));
 		}
-		else if (key == GLFW_KEY_T)
+		else if (key == GLFW_KEY_F || key == GLFW_KEY_G || key == GLFW_KEY_V || key == GLFW_KEY_B || key == GLFW_KEY_R || key == GLFW_KEY_T)
 		{
-			if (flag == 6 || flag == 0) {
-				if (zr_rotate)
-					zr_stop_time = float(glfwGetTime());
-				else
-					zr_blank_time += (float(glfwGetTime()) - zr_stop_time);
-				zr_rotate = !zr_rotate;
-			}
-			else
-				printf("> Stop rotation first!(Press '%c' to stop)\n", return_char(flag));
+			// each key toggles one direction on its axis; the opposite key reverses it
+			int axis = key == GLFW_KEY_F || key == GLFW_KEY_G ? 0 : key == GLFW_KEY_V || key == GLFW_KEY_B ? 1 : 2;
+			float dir = key == GLFW_KEY_F || key == GLFW_KEY_V || key == GLFW_KEY_R ? 1.0f : -1.0f;
+			spin[axis] = spin[axis] == dir ? 0 : dir;
+			printf("> spin = (%g, %g, %g) rad/s\n", spin.x, spin.y, spin.z);
 		}
-		else if (key == GLFW_KEY_F)
+		else if (key == GLFW_KEY_SPACE)
 		{
-			if (flag == 1 || flag == 0) {
-				if (xf_rotate)
-					xf_stop_time = float(glfwGetTime());
-				else
-					xf_blank_time += (float(glfwGetTime()) - xf_stop_time);
-				xf_rotate = !xf_rotate;
-			}
-			else
-				printf("> Stop rotation first!(Press '%c' to stop)\n", return_char(flag));
+			sim.pause(!sim.paused);
+			printf("> simulation %s at %.2f s\n", sim.paused ? "paused" : "resumed", sim.time);
 		}
-		else if (key == GLFW_KEY_G)
+		else if (key == GLFW_KEY_COMMA || key == GLFW_KEY_PERIOD)
 		{
-			if (flag == 2 || flag == 0) {
-				if (xr_rotate)
-					xr_stop_time = float(glfwGetTime());
-				else
-					xr_blank_time += (float(glfwGetTime()) - xr_stop_time);
-				xr_rotate = !xr_rotate;
-			}
-			else
-				printf("> Stop rotation first!(Press '%c' to stop)\n", return_char(flag));
+			sim.set_scale(key == GLFW_KEY_PERIOD ? sim.scale * 10 : sim.scale / 10);
+			printf("> time scale x%g\n", sim.scale);
 		}
-		else if (key == GLFW_KEY_V)
+		else if (key == GLFW_KEY_SLASH)
 		{
-			if (flag == 3 || flag == 0) {
-				if (yf_rotate)
-					yf_stop_time = float(glfwGetTime());
-				else
-					yf_blank_time += (float(glfwGetTime()) - yf_stop_time);
-				yf_rotate = !yf_rotate;
-			}
-			else
-				printf("> Stop rotation first!(Press '%c' to stop)\n", return_char(flag));
+			sim.step_once();
 		}
-		else if (key == GLFW_KEY_B)
+		else if (key == GLFW_KEY_S)
 		{
-			if (flag == 4 || flag == 0) {
-				if (yr_rotate)
-					yr_stop_time = float(glfwGetTime());
-				else
-					yr_blank_time += (float(glfwGetTime()) - yr_stop_time);
-				yr_rotate = !yr_rotate;
-			}
-			else
-				printf("> Stop rotation first!(Press '%c' to stop)\n", return_char(flag));
+			b_strip = !b_strip;
+			printf("> using triangle %s (%zu indices)\n", b_strip ? "strips" : "lists", b_strip ? sphere_sets[front].strip_index_count : sphere_sets[front].list_index_count);
+		}
+		else if (key == GLFW_KEY_P)
+		{
+			b_procedural = !b_procedural;
+			printf("> using %s sphere\n", b_procedural ? "a procedural" : "the buffered");
 		}
 		else if (key == GLFW_KEY_D)
 		{
@@ -393,15 +444,36 @@ bool user_init()
 	glClearColor( 39/255.0f, 40/255.0f, 34/255.0f, 1.0f );	// set clear color
 	glEnable( GL_CULL_FACE );								// turn on backface culling
 	glEnable( GL_DEPTH_TEST );								// turn on depth tests
+#ifdef GL_ES_VERSION_2_0
+	glEnable( GL_PRIMITIVE_RESTART_FIXED_INDEX );			// restart strips at the maximum index
+#else
+	if(gl_version_t::instance().gl()>=43) glEnable( GL_PRIMITIVE_RESTART_FIXED_INDEX );
+	else { glEnable( GL_PRIMITIVE_RESTART ); glPrimitiveRestartIndex( SPHERE_RESTART_INDEX ); } // before GL 4.3
+#endif
 
-	unit_sphere_vertices = create_sphere_vertices(NUM_TESS);
+	// the first sphere is built in place, and later ones on the worker thread
+	sphere_build* b = build_sphere(NUM_TESS);
+	update_vertex_buffer(sphere_sets[front], *b);
+	delete b;
+	if (!sphere_sets[front].vertex_array) return false;
+	worker.requested.store(NUM_TESS);
+	worker.thread = std::thread(worker_main);
 
-	update_vertex_buffer(unit_sphere_vertices, NUM_TESS);
+	glGenVertexArrays(1, &empty_vertex_array);	// core profiles need a bound vertex array even without attributes
 	return true;
 }
 
 void user_finalize()
 {
+	// stop the worker, and discard the builds not yet swapped in
+	if (worker.thread.joinable())
+	{
+		worker.quit.store(true);
+		{ std::lock_guard<std::mutex> lock(worker.mutex); }
+		worker.wake.notify_one();
+		worker.thread.join();
+	}
+	for (sphere_build* b; worker.results.pop(b); ) delete b;
 }
 
 int main( int argc, char* argv[] )
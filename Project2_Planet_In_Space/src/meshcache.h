@@ -0,0 +1,166 @@
+#pragma once
+#ifndef __MESHCACHE_H__
+#define __MESHCACHE_H__
+
+#include "cgmath.h"		// slee's simple math library
+#if defined(_WIN32)
+	#include <windows.h>
+	#include <direct.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+//*************************************
+// content-addressed cache of generated meshes on disk
+// - the key is the FNV-1a hash of a description of the generator and all its parameters;
+//   the description is stored as well, so that a hash collision reads as a miss
+// - a file holds a header, the description, and GPU-ready vertex/index blobs plus an
+//   optional application blob (e.g., draw ranges), each aligned to 16 bytes
+// - files are memory-mapped, so glBufferData() reads the blobs directly from the mapped pages
+static const char* MESH_CACHE_MAGIC = "cgmesh1";
+
+struct mesh_data // GPU-ready blobs in memory or in a mapped cache file
+{
+	const void*	vertices = nullptr;
+	size_t		vertex_bytes = 0;
+	size_t		vertex_stride = 0;
+	const void*	indices = nullptr;
+	size_t		index_bytes = 0;
+	size_t		index_size = 0;		// 2 or 4 bytes
+	const void*	aux = nullptr;
+	size_t		aux_bytes = 0;
+};
+
+struct mesh_cache_header
+{
+	char		magic[8];
+	uint64_t	key;
+	uint64_t	desc_bytes;
+	uint64_t	vertex_stride, index_size;
+	uint64_t	vertex_bytes, index_bytes, aux_bytes;
+};
+
+inline uint64_t mesh_cache_key( const std::string& desc )
+{
+	uint64_t h = 14695981039346656037ull;
+	for( unsigned char c : desc ){ h ^= c; h *= 1099511628211ull; }
+	return h;
+}
+
+inline size_t mesh_cache_align( size_t offset ){ return (offset+15)&~size_t(15); }
+
+// file path of a description in the cache directory, which is created on demand
+inline std::string mesh_cache_path( const char* dir, const std::string& desc )
+{
+#if defined(_WIN32)
+	_mkdir( dir );
+#else
+	mkdir( dir, 0755 );
+#endif
+	char name[32]; snprintf( name, sizeof(name), "/%016llx.mesh", (unsigned long long) mesh_cache_key(desc) );
+	return std::string(dir)+name;
+}
+
+// writes to a temporary file first and then renames it, so readers never map a partial file
+inline bool mesh_cache_store( const std::string& path, const std::string& desc, const mesh_data& m )
+{
+	mesh_cache_header h = {};
+	memcpy( h.magic, MESH_CACHE_MAGIC, 8 );
+	h.key = mesh_cache_key(desc); h.desc_bytes = desc.size();
+	h.vertex_stride = m.vertex_stride; h.index_size = m.index_size;
+	h.vertex_bytes = m.vertex_bytes; h.index_bytes = m.index_bytes; h.aux_bytes = m.aux_bytes;
+
+	std::string tmp = path+".tmp";
+	FILE* fp = fopen( tmp.c_str(), "wb" ); if(!fp){ printf( "[warning] %s(): unable to write %s\n", __func__, tmp.c_str() ); return false; }
+	static const char zero[16] = {};
+	size_t offset = 0; bool ok = true;
+	auto put = [&]( const void* p, size_t n ){ size_t pad=mesh_cache_align(offset)-offset; ok=ok&&fwrite(zero,1,pad,fp)==pad&&(n==0||fwrite(p,1,n,fp)==n); offset+=pad+n; };
+	put( &h, sizeof(h) ); put( desc.data(), desc.size() );
+	put( m.vertices, m.vertex_bytes ); put( m.indices, m.index_bytes ); put( m.aux, m.aux_bytes );
+	ok = fclose(fp)==0&&ok;
+#if defined(_WIN32)
+	if(ok) remove( path.c_str() ); // rename() does not replace an existing file on Windows; POSIX rename() replaces it atomically
+#endif
+	if(!ok||rename( tmp.c_str(), path.c_str() )!=0){ remove( tmp.c_str() ); printf( "[warning] %s(): unable to write %s\n", __func__, path.c_str() ); return false; }
+	return true;
+}
+
+// read-only mapping of a cache file; data() points into the mapped pages while it is open
+struct mesh_cache_file
+{
+	mesh_cache_file(){}
+	mesh_cache_file( const mesh_cache_file& ) = delete;
+	mesh_cache_file& operator=( const mesh_cache_file& ) = delete;
+	~mesh_cache_file(){ close(); }
+
+	bool open( const std::string& path, const std::string& desc )
+	{
+		close();
+		if(!map(path)) return false;
+
+		// validate the header, the description, and the blob sizes against the file size
+		const mesh_cache_header* h = (const mesh_cache_header*) ptr;
+		size_t offset = mesh_cache_align(sizeof(mesh_cache_header));
+		if(size<offset||memcmp(h->magic,MESH_CACHE_MAGIC,8)!=0||h->key!=mesh_cache_key(desc)||h->desc_bytes!=desc.size()||
+			size<offset+desc.size()||memcmp(ptr+offset,desc.data(),desc.size())!=0){ close(); return false; }
+		offset += desc.size();
+
+		const void** blob[3] = { &m.vertices, &m.indices, &m.aux };
+		uint64_t bytes[3] = { h->vertex_bytes, h->index_bytes, h->aux_bytes };
+		for( int k=0; k < 3; k++ )
+		{
+			offset = mesh_cache_align(offset); if(bytes[k]>size-min(offset,size)){ close(); return false; }
+			*blob[k] = ptr+offset; offset += size_t(bytes[k]);
+		}
+		m.vertex_bytes = size_t(h->vertex_bytes); m.index_bytes = size_t(h->index_bytes); m.aux_bytes = size_t(h->aux_bytes);
+		m.vertex_stride = size_t(h->vertex_stride); m.index_size = size_t(h->index_size);
+		return true;
+	}
+
+	const mesh_data& data() const { return m; }
+
+	void close()
+	{
+#if defined(_WIN32)
+		if(ptr) UnmapViewOfFile( ptr );
+		if(mapping){ CloseHandle( mapping ); mapping = nullptr; }
+#else
+		if(ptr) munmap( (void*) ptr, size );
+#endif
+		ptr = nullptr; size = 0; m = mesh_data();
+	}
+
+protected:
+	const char*	ptr = nullptr;
+	size_t		size = 0;
+	mesh_data	m;
+#if defined(_WIN32)
+	HANDLE		mapping = nullptr;
+#endif
+
+	bool map( const std::string& path )
+	{
+#if defined(_WIN32)
+		HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+		if(file==INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER s; if(!GetFileSizeEx(file,&s)||s.QuadPart==0){ CloseHandle(file); return false; }
+		mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		CloseHandle( file ); if(!mapping) return false;
+		ptr = (const char*) MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+		size = size_t(s.QuadPart);
+#else
+		int fd = ::open( path.c_str(), O_RDONLY ); if(fd<0) return false;
+		struct stat st; if(fstat(fd,&st)!=0||st.st_size==0){ ::close(fd); return false; }
+		void* p = mmap( nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0 );
+		::close( fd ); if(p==MAP_FAILED) return false;
+		ptr = (const char*) p; size = size_t(st.st_size);
+#endif
+		if(!ptr){ close(); return false; }
+		return true;
+	}
+};
+
+#endif // __MESHCACHE_H__
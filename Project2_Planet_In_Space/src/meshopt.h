@@ -0,0 +1,154 @@
+#pragma once
+#ifndef __MESHOPT_H__
+#define __MESHOPT_H__
+
+#include <algorithm>	// include before cgmath.h, which defines min/max macros
+#include "cgmath.h"		// slee's simple math library
+
+//*************************************
+// post-transform vertex cache and vertex fetch optimization for indexed triangle lists
+// - optimize_vertex_cache(): reorders triangles by Tom Forsyth's linear-speed algorithm,
+//   which greedily emits the triangle whose vertices score highest in a simulated LRU cache
+// - optimize_vertex_fetch(): reorders vertices in the order of first use, so the vertex
+//   fetch walks memory nearly sequentially; run it after optimize_vertex_cache()
+// - optimize_mesh(): both in order, for loaders such as cg_load_mesh(...,optimize_mesh<vertex>)
+// - analyze_*(): ACMR/ATVR on a FIFO cache and overfetch on 64-byte cache lines
+
+static const int VCACHE_SIZE = 32;	// simulated cache entries for the optimization
+
+inline float vcache_vertex_score( int cache_position, uint remaining )
+{
+	if(remaining==0) return -1.0f; // no triangle needs this vertex anymore
+	float s = 0;
+	if(cache_position>=0) s = cache_position<3 ? 0.75f : powf(1.0f-float(cache_position-3)/float(VCACHE_SIZE-3),1.5f); // the last triangle gets a fixed score
+	return s+2.0f/sqrtf(float(remaining)); // boost vertices with few triangles left
+}
+
+// indices: triangles to reorder in place; vertex_count: bound of the index values
+inline void optimize_vertex_cache( uint* indices, size_t index_count, size_t vertex_count )
+{
+	size_t triangle_count = index_count/3; if(triangle_count<2) return;
+
+	// triangle adjacency of vertices in compressed rows; remaining[v] is the live length of row v
+	std::vector<uint> offset(vertex_count+1,0), remaining(vertex_count,0), adjacency(index_count);
+	for( size_t k=0; k < index_count; k++ ) remaining[indices[k]]++;
+	for( size_t v=0; v < vertex_count; v++ ) offset[v+1] = offset[v]+remaining[v];
+	std::vector<uint> fill(offset.begin(), offset.end()-1);
+	for( size_t k=0; k < index_count; k++ ) adjacency[fill[indices[k]]++] = uint(k/3);
+
+	std::vector<float> vertex_score(vertex_count), triangle_score(triangle_count,0);
+	std::vector<bool> emitted(triangle_count,false);
+	for( size_t v=0; v < vertex_count; v++ ) vertex_score[v] = vcache_vertex_score(-1,remaining[v]);
+	for( size_t k=0; k < index_count; k++ ) triangle_score[k/3] += vertex_score[indices[k]];
+
+	std::vector<uint> result; result.reserve(index_count);
+	std::vector<uint> cache, next_cache; cache.reserve(VCACHE_SIZE+3); next_cache.reserve(VCACHE_SIZE+3);
+	size_t cursor = 0; // dead end: no cached vertex has live triangles, so take the next one in order
+	int best = -1;
+	for( size_t emitted_count=0; emitted_count < triangle_count; emitted_count++ )
+	{
+		if(best<0){ while(emitted[cursor]) cursor++; best=int(cursor); }
+
+		// emit the triangle and detach it from its vertices
+		const uint* tri = indices+size_t(best)*3;
+		emitted[best] = true;
+		for( int j=0; j < 3; j++ )
+		{
+			uint v = tri[j]; result.push_back(v);
+			uint* row = &adjacency[offset[v]]; uint n = remaining[v];
+			for( uint a=0; a < n; a++ ) if(row[a]==uint(best)){ row[a]=row[n-1]; break; }
+			remaining[v] = n-1;
+		}
+
+		// move the triangle vertices to the front of the LRU cache
+		next_cache.assign( tri, tri+3 );
+		for( uint v : cache ) if(v!=tri[0]&&v!=tri[1]&&v!=tri[2]) next_cache.push_back(v);
+		cache.swap(next_cache);
+
+		// rescore the cached vertices and their live triangles, and pick the next best
+		best = -1; float best_score = -1.0f;
+		for( size_t c=0; c < cache.size(); c++ )
+		{
+			uint v = cache[c]; int p = c<size_t(VCACHE_SIZE) ? int(c) : -1;
+			float s = vcache_vertex_score(p,remaining[v]), ds = s-vertex_score[v]; vertex_score[v] = s;
+			for( uint a=0; a < remaining[v]; a++ )
+			{
+				uint t = adjacency[offset[v]+a]; triangle_score[t] += ds;
+				if(triangle_score[t]>best_score){ best_score=triangle_score[t]; best=int(t); }
+			}
+		}
+		if(cache.size()>size_t(VCACHE_SIZE)) cache.resize(VCACHE_SIZE);
+	}
+	memcpy( indices, result.data(), sizeof(uint)*index_count );
+}
+
+inline void optimize_vertex_cache( std::vector<uint>& indices, size_t vertex_count ){ optimize_vertex_cache( indices.data(), indices.size(), vertex_count ); }
+
+// vertices are renumbered by their first use; unreferenced ones move to the end
+// primitive restart indices (~0u) are kept as they are
+template <class V> void optimize_vertex_fetch( std::vector<V>& vertices, std::vector<uint>& indices )
+{
+	std::vector<uint> remap(vertices.size(),~0u);
+	std::vector<V> v; v.reserve(vertices.size());
+	for( auto& i : indices ){ if(i==~0u) continue; if(remap[i]==~0u){ remap[i]=uint(v.size()); v.push_back(vertices[i]); } i = remap[i]; }
+	for( size_t k=0; k < vertices.size(); k++ ) if(remap[k]==~0u) v.push_back(vertices[k]);
+	vertices.swap(v);
+}
+
+// both passes on a triangle list; a count that is not a multiple of three or an index
+// out of range (e.g., a restart index) means another topology, which is left as it is
+template <class V> void optimize_mesh( std::vector<V>& vertices, std::vector<uint>& indices )
+{
+	if(indices.size()%3||!std::all_of(indices.begin(),indices.end(),[&](uint k){ return k<vertices.size(); })) return;
+	optimize_vertex_cache( indices, vertices.size() );
+	optimize_vertex_fetch( vertices, indices );
+}
+
+//*************************************
+// acmr: transformed vertices per triangle (0.5 is the ideal of a large regular grid)
+// atvr: transformed vertices per referenced vertex (1.0 is the ideal)
+struct vcache_stats
+{
+	float acmr = 0;
+	float atvr = 0;
+};
+
+inline vcache_stats analyze_vertex_cache( const uint* indices, size_t index_count, size_t vertex_count, uint cache_size=16 )
+{
+	vcache_stats s; if(index_count<3) return s;
+	std::vector<size_t> timestamp(vertex_count,0); // FIFO: a vertex is cached if it entered within cache_size misses
+	std::vector<bool> referenced(vertex_count,false);
+	size_t misses=0, unique=0;
+	for( size_t k=0; k < index_count; k++ )
+	{
+		uint v = indices[k];
+		if(!referenced[v]){ referenced[v]=true; unique++; }
+		if(timestamp[v]==0||misses-timestamp[v]>=cache_size){ misses++; timestamp[v]=misses; }
+	}
+	s.acmr = float(misses)/float(index_count/3);
+	s.atvr = float(misses)/float(unique);
+	return s;
+}
+
+inline vcache_stats analyze_vertex_cache( const std::vector<uint>& indices, size_t vertex_count, uint cache_size=16 ){ return analyze_vertex_cache( indices.data(), indices.size(), vertex_count, cache_size ); }
+
+// bytes fetched through 64-byte lines of a small direct-mapped cache, over the bytes
+// of the referenced vertices (1.0 is the ideal)
+inline float analyze_vertex_fetch( const uint* indices, size_t index_count, size_t vertex_count, size_t vertex_size, size_t cache_bytes=16384 )
+{
+	const size_t line = 64, lines = cache_bytes/line;
+	std::vector<size_t> tag(lines,~size_t(0));
+	std::vector<bool> referenced(vertex_count,false);
+	size_t fetched=0, unique=0;
+	for( size_t k=0; k < index_count; k++ )
+	{
+		uint v = indices[k]; if(!referenced[v]){ referenced[v]=true; unique++; }
+		for( size_t a=v*vertex_size/line, b=((v+1)*vertex_size-1)/line; a <= b; a++ )
+			if(tag[a%lines]!=a){ tag[a%lines]=a; fetched+=line; }
+	}
+	return unique ? float(fetched)/float(unique*vertex_size) : 0;
+}
+
+inline float analyze_vertex_fetch( const std::vector<uint>& indices, size_t vertex_count, size_t vertex_size ){ return analyze_vertex_fetch( indices.data(), indices.size(), vertex_count, vertex_size ); }
+
+#endif // __MESHOPT_H__
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef __SIMCLOCK_H__
+#define __SIMCLOCK_H__
+
+#include "cgmath.h"		// slee's simple math library
+
+//*************************************
+// simulation clock in double precision
+// - the time is kept in double: a float of an hour (3600 s) resolves only 0.24 ms, which
+//   shows up as jitter of anything moving faster than a few units per second
+// - tick() advances by the wall time since the last tick, multiplied by the scale, unless
+//   paused; a long stall (breakpoint, dragged window) is cut to MAX_FRAME
+// - with fixed_dt>0, each tick advances by exactly fixed_dt*scale regardless of the wall
+//   clock, so runs are deterministic, and headless runs can fast-forward by ticking in a loop
+// - steps() hands the advanced time out in fixed substeps for integrators; a consumer that
+//   caps its substeps should limit_scale() to reachable_scale(), so the scale it shows is
+//   the one it runs at, and any time still dropped (e.g., at a lower frame rate) is counted
+struct sim_clock
+{
+	static constexpr double MIN_SCALE = 0.01, MAX_SCALE = 1e6;
+	static constexpr double MAX_FRAME = 0.25;	// most wall seconds of a tick
+
+	double	time = 0;			// simulation seconds
+	double	dt = 0;				// simulation seconds advanced by the last tick
+	double	scale = 1;			// simulation seconds per wall second
+	double	fixed_dt = 0;		// wall seconds per tick if positive; 0 follows the wall clock
+	double	max_scale = MAX_SCALE;	// the limit of the consumers, set by limit_scale()
+	double	dropped = 0;		// simulation seconds that steps() dropped beyond its cap
+	bool	paused = false;
+
+	// call once per frame, e.g., with glfwGetTime()
+	void tick( double wall_time )
+	{
+		double elapsed = fixed_dt>0 ? fixed_dt : last<0 ? 0 : min(max(wall_time-last,0.0),MAX_FRAME);
+		last = wall_time;
+		if(paused&&!single) elapsed = 0;
+		else if(single) elapsed = fixed_dt>0 ? fixed_dt : 1.0/60.0;
+		single = false;
+		dt = elapsed*scale; time += dt;
+	}
+
+	void pause( bool b ){ paused = b; }
+	void set_scale( double s ){ scale = min(max(s,MIN_SCALE),max_scale); }
+	void limit_scale( double s ){ max_scale = min(max(s,MIN_SCALE),MAX_SCALE); set_scale(scale); }
+	void step_once(){ single = true; }	// the next tick advances by one frame, also when paused
+
+	// the largest scale that max_steps substeps of h per frame can follow at the frame rate
+	static double reachable_scale( double h, uint max_steps, double frames_per_second=60.0 ){ return h*max_steps*frames_per_second; }
+
+	// number of fixed substeps of h covering the time advanced so far; the remainder carries
+	// over to the next tick, and a backlog beyond max_steps is dropped (and counted in dropped)
+	// instead of piling up
+	uint steps( double h, uint max_steps )
+	{
+		backlog += dt;
+		double n = floor(backlog/h);
+		if(n>max_steps){ dropped += backlog-max_steps*h; backlog = 0; return max_steps; }
+		backlog -= n*h;
+		return uint(n);
+	}
+
+protected:
+	double	last = -1;			// wall time of the last tick
+	double	backlog = 0;		// simulation seconds not yet handed out by steps()
+	bool	single = false;
+};
+
+#endif // __SIMCLOCK_H__
@@ -0,0 +1,226 @@
+#pragma once
+#ifndef __SPHERE_H__
+#define __SPHERE_H__
+
+#include "cgmath.h"		// slee's simple math library
+#include "cgut.h"		// struct vertex
+
+//*************************************
+// uv-sphere tessellation with N segments in longitude and N/2 rings in latitude
+// - vertex 0 is a placeholder at the origin; indices are offset by one
+// - grid vertices follow in segment-major order: (N+1) segments x (N/2+1) rings
+// - trigonometry is evaluated once per angle (O(N)) instead of per vertex (O(N^2))
+// - buffers are allocated exactly once, and segments are filled in parallel with OpenMP
+
+// angles of 2*PI*k/n for k in [0,count), and their cos/sin
+struct sincos_table
+{
+	std::vector<float> a, c, s;
+	sincos_table( uint n, uint count ) : a(count), c(count), s(count)
+	{
+		for( uint k=0; k < count; k++ ){ a[k]=PI*2.0f*k/float(n); c[k]=cos(a[k]); s[k]=sin(a[k]); }
+	}
+};
+
+// y_up: poles on the y axis (Project 3); otherwise, on the z axis (Project 2)
+// the normal always keeps the z-up direction, which is used as the vertex color
+inline std::vector<vertex> create_sphere_vertices( uint N, bool y_up=false )
+{
+	const uint R = N/2+1; // vertices per segment
+	sincos_table theta(N,R), phi(N,N+1);
+
+	std::vector<vertex> v(1+size_t(N+1)*R);
+	v[0] = { vec3(0), vec3(0,0,-1.0f), vec2(0.5f) };
+
+	#pragma omp parallel for
+	for( int i=0; i <= int(N); i++ )
+	{
+		const float pc=phi.c[i], ps=phi.s[i], u=phi.a[i]/(2.0f*PI);
+		vertex* row = &v[1+size_t(i)*R];
+		if(y_up) for( uint j=0; j < R; j++ )
+		{
+			float tc=theta.c[j], ts=theta.s[j];
+			row[j] = { vec3(ts*ps, tc, ts*pc), vec3(ts*pc, ts*ps, tc), vec2(u, 1.0f-theta.a[j]/PI) };
+		}
+		else for( uint j=0; j < R; j++ )
+		{
+			float tc=theta.c[j], ts=theta.s[j];
+			row[j] = { vec3(ts*pc, ts*ps, tc), vec3(ts*pc, ts*ps, tc), vec2(u, 1.0f-theta.a[j]/PI) };
+		}
+	}
+	return v;
+}
+
+// two front-facing triangles per grid cell: N*(N/2)*6 indices
+inline std::vector<uint> create_sphere_indices( uint N )
+{
+	const uint R = N/2+1, H = N/2;
+	std::vector<uint> indices(size_t(N)*H*6);
+
+	#pragma omp parallel for
+	for( int i=0; i < int(N); i++ )
+	{
+		uint* p = &indices[size_t(i)*H*6];
+		for( uint j=0, k=i*R+1; j < H; j++, k++, p+=6 )
+		{
+			p[0]=k; p[1]=k+1; p[2]=k+R+1;
+			p[3]=k; p[4]=k+R+1; p[5]=k+R;
+		}
+	}
+	return indices;
+}
+
+// triangle strips of the same grid: one strip per segment, separated by primitive restarts
+// - N*(N+3) indices instead of N*(N/2)*6, with the same triangles and the same winding
+// - the restart index ~0u is the fixed index of 32-bit indices, and truncates to 0xffff
+static const uint SPHERE_RESTART_INDEX = ~0u;
+
+inline std::vector<uint> create_sphere_strip_indices( uint N )
+{
+	const uint R = N/2+1;
+	std::vector<uint> indices(size_t(N)*(2*R+1));
+
+	#pragma omp parallel for
+	for( int i=0; i < int(N); i++ )
+	{
+		uint* p = &indices[size_t(i)*(2*R+1)];
+		for( uint j=0, k=i*R+1; j < R; j++, k++ ){ *p++ = k+R; *p++ = k; }
+		*p = SPHERE_RESTART_INDEX;
+	}
+	return indices;
+}
+
+//*************************************
+// welded alternatives to the uv sphere: no pole clustering and no duplicated seam
+// - each position is stored once (welded through a hash map), and triangles are front-facing
+// - the normal keeps the z-up direction and texcoords follow the uv-sphere parameterization,
+//   so the shaders see the same attributes; texcoords wrap across the u=0 seam
+struct sphere_mesh
+{
+	std::vector<vertex>	vertices;
+	std::vector<uint>	indices;
+	size_t triangle_count() const { return indices.size()/3; }
+};
+
+// vertex on the unit sphere from its z-up direction n
+inline vertex sphere_vertex( vec3 n, bool y_up )
+{
+	float u = atan2(n.y,n.x)/(2.0f*PI); if(u<0) u+=1.0f;
+	return { y_up ? vec3(n.y,n.z,n.x) : n, n, vec2(u, 1.0f-acos(clamp(n.z,-1.0f,1.0f))/PI) };
+}
+
+// icosahedron subdivided level times: 20*4^level triangles, 10*4^level+2 vertices
+// each edge midpoint is created once and shared by the two triangles on the edge
+inline sphere_mesh create_icosphere( uint level, bool y_up=false )
+{
+	const float t = (1.0f+sqrt(5.0f))*0.5f;
+	std::vector<vec3> p =
+	{
+		{-1, t, 0}, { 1, t, 0}, {-1,-t, 0}, { 1,-t, 0},
+		{ 0,-1, t}, { 0, 1, t}, { 0,-1,-t}, { 0, 1,-t},
+		{ t, 0,-1}, { t, 0, 1}, {-t, 0,-1}, {-t, 0, 1},
+	};
+	std::vector<uint> f =
+	{
+		0,11,5,	0,5,1,	0,1,7,	0,7,10,	0,10,11,
+		1,5,9,	5,11,4,	11,10,2,	10,7,6,	7,1,8,
+		3,9,4,	3,4,2,	3,2,6,	3,6,8,	3,8,9,
+		4,9,5,	2,4,11,	6,2,10,	8,6,7,	9,8,1,
+	};
+	for( auto& v : p ) v = v.normalize();
+
+	size_t nv = 10*(size_t(1)<<(2*level))+2;
+	p.reserve(nv);
+	for( uint l=0; l < level; l++ )
+	{
+		std::unordered_map<uint64_t,uint> midpoint; midpoint.reserve(f.size()/2);
+		auto mid = [&]( uint a, uint b ) -> uint
+		{
+			uint64_t key = a<b ? (uint64_t(a)<<32)|b : (uint64_t(b)<<32)|a;
+			auto it = midpoint.find(key); if(it!=midpoint.end()) return it->second;
+			p.emplace_back((p[a]+p[b]).normalize());
+			return midpoint[key] = uint(p.size()-1);
+		};
+
+		std::vector<uint> g; g.reserve(f.size()*4);
+		for( size_t k=0; k < f.size(); k+=3 )
+		{
+			uint a=f[k], b=f[k+1], c=f[k+2], ab=mid(a,b), bc=mid(b,c), ca=mid(c,a);
+			g.insert(g.end(), { a,ab,ca, b,bc,ab, c,ca,bc, ab,bc,ca });
+		}
+		f.swap(g);
+	}
+
+	sphere_mesh m; m.vertices.resize(p.size()); m.indices.swap(f);
+	for( size_t k=0; k < p.size(); k++ ) m.vertices[k] = sphere_vertex(p[k],y_up);
+	return m;
+}
+
+// cube with N x N quads per face projected onto the sphere: 12*N^2 triangles, 6*N^2+2 vertices
+// - lattice points of the cube surface are welded by their integer coordinates, which
+//   merges the face edges and corners exactly
+// - the projection spreads points evenly: x*sqrt(1-y^2/2-z^2/2+y^2*z^2/3) for each axis
+inline sphere_mesh create_cubesphere( uint N, bool y_up=false )
+{
+	N = max(N,1u);
+	sphere_mesh m;
+	m.vertices.reserve(6*size_t(N)*N+2);
+	m.indices.reserve(36*size_t(N)*N);
+
+	std::unordered_map<uint64_t,uint> lattice; lattice.reserve(6*size_t(N)*N+2);
+	auto weld = [&]( uint x, uint y, uint z ) -> uint
+	{
+		uint64_t key = (uint64_t(x)*(N+1)+y)*(N+1)+z;
+		auto it = lattice.find(key); if(it!=lattice.end()) return it->second;
+		vec3 c = vec3(float(x),float(y),float(z))*(2.0f/float(N))-1.0f, c2=c*c;
+		vec3 n = vec3(	c.x*sqrt(max(0.0f,1.0f-c2.y*0.5f-c2.z*0.5f+c2.y*c2.z/3.0f)),
+						c.y*sqrt(max(0.0f,1.0f-c2.z*0.5f-c2.x*0.5f+c2.z*c2.x/3.0f)),
+						c.z*sqrt(max(0.0f,1.0f-c2.x*0.5f-c2.y*0.5f+c2.x*c2.y/3.0f)) );
+		m.vertices.emplace_back(sphere_vertex(n.normalize(),y_up));
+		return lattice[key] = uint(m.vertices.size()-1);
+	};
+
+	for( uint face=0; face < 6; face++ )
+	{
+		// face axis k; (u,v) spans the face with cross(u,v) pointing outward
+		uint k=face%3, sign=face/3, u=sign?(k+1)%3:(k+2)%3, v=sign?(k+2)%3:(k+1)%3;
+		for( uint a=0; a < N; a++ ) for( uint b=0; b < N; b++ )
+		{
+			uint q[4], ab[4][2] = { {a,b}, {a+1,b}, {a+1,b+1}, {a,b+1} };
+			for( int j=0; j < 4; j++ ){ uint c[3]; c[k]=sign?N:0; c[u]=ab[j][0]; c[v]=ab[j][1]; q[j]=weld(c[0],c[1],c[2]); }
+			m.indices.insert(m.indices.end(), { q[0],q[1],q[2], q[0],q[2],q[3] });
+		}
+	}
+	return m;
+}
+
+//*************************************
+// level-of-detail chain of uv spheres packed into a single vertex/index buffer
+// - indices of each level are rebased to its vertex range, so one VAO draws any level
+// - error: the largest gap between the sphere and a triangle plane as a fraction of
+//   the radius, found at the equator cells: 1-cos(sqrt(2)*PI/N)
+struct sphere_lod
+{
+	uint	segments;
+	size_t	first_index;
+	size_t	index_count;
+	float	error;
+};
+
+inline std::vector<sphere_lod> create_sphere_lod_chain( const std::vector<uint>& segments, std::vector<vertex>& vertices, std::vector<uint>& indices, bool y_up=false )
+{
+	std::vector<sphere_lod> lods;
+	vertices.clear(); indices.clear();
+	for( uint N : segments )
+	{
+		std::vector<vertex> v = create_sphere_vertices(N,y_up);
+		std::vector<uint> i = create_sphere_indices(N);
+		uint base = uint(vertices.size()); for( auto& k : i ) k += base;
+		lods.push_back({ N, indices.size(), i.size(), 1.0f-cos(sqrt(2.0f)*PI/float(N)) });
+		vertices.insert( vertices.end(), v.begin(), v.end() );
+		indices.insert( indices.end(), i.begin(), i.end() );
+	}
+	return lods;
+}
+
+#endif // __SPHERE_H__
@@ -0,0 +1,45 @@
+#pragma once
+#ifndef __SPSC_H__
+#define __SPSC_H__
+
+#include <atomic>
+
+//*************************************
+// lock-free queue of a single producer thread and a single consumer thread
+// - a ring of a power-of-two capacity; head/tail are free-running counters
+// - the release store of tail publishes the pushed slot to the consumer, and
+//   the release store of head returns the popped slot to the producer
+// - head and tail live on separate cache lines, so the two threads do not false-share
+template <class T, size_t capacity> struct spsc_queue
+{
+	static_assert( capacity>0&&(capacity&(capacity-1))==0, "capacity should be a power of two" );
+
+	// producer only: false when full
+	bool push( const T& v )
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		if(t-head.load(std::memory_order_acquire)==capacity) return false;
+		ring[t&(capacity-1)] = v;
+		tail.store( t+1, std::memory_order_release );
+		return true;
+	}
+
+	// consumer only: false when empty
+	bool pop( T& v )
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		if(h==tail.load(std::memory_order_acquire)) return false;
+		v = ring[h&(capacity-1)];
+		head.store( h+1, std::memory_order_release );
+		return true;
+	}
+
+	bool empty() const { return head.load(std::memory_order_acquire)==tail.load(std::memory_order_acquire); }
+
+protected:
+	alignas(64) std::atomic<size_t> head{0};
+	alignas(64) std::atomic<size_t> tail{0};
+	T ring[capacity];
+};
+
+#endif // __SPSC_H__
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <chrono>		// include before cgmath.h, which defines min/max macros
+#include "cgmath.h"		// slee's simple math library
+
+//*************************************
+// build configuration: passed by the makefile to tag reports and baselines
+#ifndef BENCH_OPT
+	#define BENCH_OPT ""
+#endif
+#if defined(__clang__)
+	#define BENCH_COMPILER "clang " __clang_version__
+#elif defined(__GNUC__)
+	#define BENCH_COMPILER "gcc " __VERSION__
+#elif defined(_MSC_VER)
+	#define BENCH_COMPILER "msvc"
+#else
+	#define BENCH_COMPILER "unknown"
+#endif
+
+//*************************************
+// timer: the best of several trials, each repeated long enough to be measurable
+// - the first trial only warms up caches and branch predictors, and is not counted
+// - warm_up() spins before the first kernel of a run, so the clock has ramped up by then
+struct bench_timer
+{
+	double	min_seconds = 0.02;	// minimum duration of a single trial
+	int		trials = 5;
+
+	static void warm_up( double seconds=0.2 )
+	{
+		using clock = std::chrono::high_resolution_clock;
+		volatile double x = 0; auto t0 = clock::now();
+		while(std::chrono::duration<double>(clock::now()-t0).count()<seconds) for( int k=0; k < 1000; k++ ) x = x+1.0;
+	}
+
+	template <class F> double ns_per_op( F f, size_t ops_per_call ) const
+	{
+		using clock = std::chrono::high_resolution_clock;
+		size_t repeat = 1;
+		for(;;) // calibrate the repeat count
+		{
+			auto t0 = clock::now(); for( size_t r=0; r < repeat; r++ ) f();
+			double s = std::chrono::duration<double>(clock::now()-t0).count();
+			if(s>=min_seconds) break;
+			repeat *= s<min_seconds*0.1 ? 10 : 2;
+		}
+
+		double best = DBL_MAX;
+		for( int k=-1; k < trials; k++ ) // k=-1: warm-up
+		{
+			auto t0 = clock::now(); for( size_t r=0; r < repeat; r++ ) f();
+			double ns = std::chrono::duration<double,std::nano>(clock::now()-t0).count();
+			if(k>=0) best = min(best, ns/double(repeat*ops_per_call));
+		}
+		return best;
+	}
+};
+
+// random inputs in [a,b]
+inline float bench_rand( float a=-1.0f, float b=1.0f ){ return a+(b-a)*float(rand())/float(RAND_MAX); }
+
+#endif // __BENCH_H__
@@ -0,0 +1,40 @@
+#include "bench.h"
+#include "belt.h"
+
+//*************************************
+// analytic evaluation of belt positions from SoA orbital elements
+// usage: bench_belt [count=1000000]
+int main( int argc, char* argv[] )
+{
+	size_t count = argc>1 ? size_t(atoll(argv[1])) : 1000000;
+	bench_timer timer; timer.trials = 3;
+	belt_desc d = { "belt", -1, uint(count), 39, 46, 0.8f, 0.03f, 0.25f, 1.2f, vec3(1), 0.47f };
+	particle_belt b; b.create( d );
+
+	// the polynomial sincos over a wide range of angles
+	double es = 0;
+	for( float a=-5000.0f; a < 5000.0f; a+=0.0137f ){ float s, c; fast_sincos(a,s,c); es = max(es,max(std::abs(s-sin(double(a))),std::abs(c-cos(double(a))))); }
+
+	// accuracy against the same elements evaluated in double, after an hour and a year
+	auto max_error = [&]( double t )
+	{
+		double e = 0;
+		b.evaluate( t );
+		for( size_t k=0; k < b.size(); k++ )
+		{
+			double a = b.phase[k]+b.speed[k]*t;
+			dvec3 l( b.radius[k]*sin(a), b.height_cos[k]*sin(a)+b.height_sin[k]*cos(a), b.radius[k]*cos(a) );
+			dvec3 p( b.tilt._11*l.x+b.tilt._12*l.y+b.tilt._13*l.z, b.tilt._21*l.x+b.tilt._22*l.y+b.tilt._23*l.z, b.tilt._31*l.x+b.tilt._32*l.y+b.tilt._33*l.z );
+			e = max(e,(p-dvec3(b.x[k],b.y[k],b.z[k])).length());
+		}
+		return e;
+	};
+	double e_year = max_error( 3.15e7 ), t = 3600.0, e = max_error( t );
+
+	double ns = timer.ns_per_op( [&](){ b.evaluate( t+=0.016 ); }, count );
+	printf( "[bench_belt] %s %s, %zu bodies\n", BENCH_COMPILER, BENCH_OPT, count );
+	printf( "evaluate: %.2f ns/body, %.2f ms/frame; max error after an hour %.3g, after a year %.3g\n", ns, ns*double(count)*1e-6, e, e_year );
+	printf( "fast_sincos: max error %.3g in [-5000,5000]\n", es );
+
+	return 0;
+}
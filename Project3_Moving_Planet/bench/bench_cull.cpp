@@ -0,0 +1,46 @@
+#include "bench.h"
+
+static void report( const char* name, double ns, size_t count, size_t visible )
+{
+	printf( "%-22s %8.3f ns/test %10.2f M tests/s  (visible %zu/%zu)\n", name, ns, 1e3/ns, visible, count );
+}
+
+int main( int argc, char* argv[] )
+{
+	size_t count = argc>1 ? size_t(atoll(argv[1])) : 1<<20;
+	bench_timer timer;
+
+	// the same camera setup as Project3
+	mat4 view_projection = mat4::perspective( PI/4.0f, 16/9.0f, 1.0f, 1000.0f )*mat4::look_at( vec3(0,100,200), vec3(0), vec3(0,1,0) );
+	frustum f( view_projection );
+
+	// objects scattered around a solar-system-sized volume
+	srand(0);
+	std::vector<sphere3> spheres(count);
+	std::vector<aabb3> boxes(count);
+	for( size_t k=0; k < count; k++ )
+	{
+		spheres[k] = sphere3( vec3(bench_rand(-500,500),bench_rand(-200,200),bench_rand(-500,500)), bench_rand(0.1f,10.0f) );
+		boxes[k] = aabb3( spheres[k] );
+	}
+	std::vector<uchar> visible(count);
+	size_t n=0;
+
+	printf( "[bench_cull] %s %s, %zu objects\n", BENCH_COMPILER, BENCH_OPT, count );
+	double ns = timer.ns_per_op( [&](){ n=0; for( size_t k=0; k < count; k++ ) n+=(visible[k]=f.intersects(spheres[k])); }, count );
+	report( "sphere-frustum scalar", ns, count, n );
+	ns = timer.ns_per_op( [&](){ n=f.cull( spheres.data(), count, visible.data() ); }, count );
+	report( "sphere-frustum batch", ns, count, n );
+	ns = timer.ns_per_op( [&](){ n=0; for( size_t k=0; k < count; k++ ) n+=(visible[k]=f.intersects(boxes[k])); }, count );
+	report( "aabb-frustum scalar", ns, count, n );
+	ns = timer.ns_per_op( [&](){ n=f.cull( boxes.data(), count, visible.data() ); }, count );
+	report( "aabb-frustum batch", ns, count, n );
+
+	// the sun between the eye and the scene, in eye-relative coordinates
+	sphere_occluder o( sphere3( vec3(0,-100,-200), 15.0f ) );
+	std::vector<sphere3> relative(count); for( size_t k=0; k < count; k++ ) relative[k] = sphere3( spheres[k].center-vec3(0,100,200), spheres[k].radius );
+	ns = timer.ns_per_op( [&](){ n=0; for( size_t k=0; k < count; k++ ) n+=(visible[k]=!o.occludes(relative[k])); }, count );
+	report( "sphere occluder", ns, count, n );
+
+	return 0;
+}
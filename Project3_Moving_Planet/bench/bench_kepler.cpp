@@ -0,0 +1,58 @@
+#include "bench.h"
+#include "kepler.h"
+
+//*************************************
+// kepler's equation: the batched fixed-step newton solve against an iterated double
+// solve, and ephemeris lookups against the solve
+// usage: bench_kepler [count=1000000]
+static double kepler_solve_ref( double M, double e )
+{
+	double E = M+(M<0?-0.85:0.85)*e;
+	for( int k=0; k < 50; k++ ){ double d=(E-e*sin(E)-M)/(1.0-e*cos(E)); E-=d; if(fabs(d)<1e-15) break; }
+	return E;
+}
+
+int main( int argc, char* argv[] )
+{
+	size_t count = argc>1 ? size_t(atoll(argv[1])) : 1000000;
+	bench_timer timer; timer.trials = 3;
+	printf( "[bench_kepler] %s %s, %zu bodies\n", BENCH_COMPILER, BENCH_OPT, count );
+
+	// accuracy of the fixed-step solve over the whole range of mean anomalies
+	for( float e : { 0.0f, 0.2f, 0.5f, 0.7f, 0.9f, 0.97f } )
+	{
+		double err = 0;
+		for( float M=-PI; M <= PI; M+=0.0007f ) err = max(err,std::abs(double(kepler_solve(M,e))-kepler_solve_ref(M,e)));
+		printf( "solve: e=%.2f, max error of E %.3g\n", e, err );
+	}
+
+	// batched solve and positions; eccentricities of asteroids
+	std::vector<float> M(count), e(count), E(count);
+	for( size_t k=0; k < count; k++ ){ M[k]=bench_rand(-PI,PI); e[k]=bench_rand(0,0.3f); }
+	double ns_ref = timer.ns_per_op( [&](){ for( size_t k=0; k < count; k++ ) E[k]=float(kepler_solve_ref(M[k],e[k])); }, count );
+	double ns = timer.ns_per_op( [&](){ kepler_solve( M.data(), e.data(), E.data(), count ); }, count );
+	printf( "solve: %.2f ns/body batched, %.2f ns/body iterated in double with libm\n", ns, ns_ref );
+
+	// ephemeris of a mercury-like orbit against the solve
+	kepler_orbit o( 20, 0.2056f, 0.5f, radians(7.0f), radians(48.3f), radians(29.1f) );
+	for( uint samples : { 64u, 256u, 1024u } )
+	{
+		kepler_ephemeris x; x.create( o, samples );
+		double err = 0;
+		for( double t=-100.0; t < 100.0; t+=0.0013 ) err = max(err,length(x.position(t)-o.position(t)));
+		printf( "ephemeris: %4u samples/period, max error %.3g (a=20, e=0.2056)\n", samples, err );
+	}
+
+	kepler_ephemeris x; x.create( o, 256 );
+	std::vector<double> t(count); for( size_t k=0; k < count; k++ ) t[k]=bench_rand(0,3600.0f);
+	std::vector<dvec3> p(count);
+	double ns_scalar = timer.ns_per_op( [&](){ for( size_t k=0; k < count; k++ ) p[k]=o.position(t[k]); }, count );
+	double ns_batch = timer.ns_per_op( [&](){
+		for( size_t k=0; k < count; k++ ){ M[k]=o.mean_anomaly(t[k]); e[k]=o.e; }
+		kepler_solve( M.data(), e.data(), E.data(), count );
+		for( size_t k=0; k < count; k++ ) p[k]=o.position_at(E[k]); }, count );
+	double ns_table = timer.ns_per_op( [&](){ for( size_t k=0; k < count; k++ ) p[k]=x.position(t[k]); }, count );
+	printf( "position: %.2f ns solved one by one, %.2f ns solved in a batch, %.2f ns from the ephemeris\n", ns_scalar, ns_batch, ns_table );
+
+	return 0;
+}
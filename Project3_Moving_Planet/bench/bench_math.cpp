@@ -0,0 +1,157 @@
+#include "bench.h"
+
+//*************************************
+// usage: bench_math [--save file] [--baseline file] [--threshold 0.15]
+// - --save writes the best ns/op of every kernel over 1+RETRIES measurements
+// - --baseline compares against a saved file and fails (exit code 1)
+//   when any kernel is slower than baseline*(1+threshold), or when the file is missing
+// - a baseline holds absolute timings, so it is only valid on the machine that saved it
+// - a kernel over the threshold is measured again up to RETRIES times, and only the best
+//   counts, so a briefly busy machine does not fail the gate
+static const size_t	N = 1024;	// inputs per call: large enough to hide loop overhead, small enough for L1/L2
+static const int	RETRIES = 3;
+
+struct kernel_result
+{
+	std::string	name;
+	double		ns;
+};
+
+//*************************************
+// random inputs shared by all kernels
+struct inputs
+{
+	std::vector<float>	f;
+	std::vector<vec2>	v2[2];
+	std::vector<vec3>	v3[3];
+	std::vector<vec4>	v4[2];
+	std::vector<mat3>	m3[2];
+	std::vector<mat4>	m4[2];
+	std::vector<mat4x3>	m43[2];
+
+	inputs()
+	{
+		srand(0);
+		f.resize(N); for( auto& x : f ) x = bench_rand( 0.1f, 3.0f );
+		for( auto& a : v2 ){ a.resize(N); for( auto& v : a ) v = vec2(bench_rand(),bench_rand()); }
+		for( auto& a : v3 ){ a.resize(N); for( auto& v : a ) v = vec3(bench_rand(),bench_rand(),bench_rand()); }
+		for( auto& a : v4 ){ a.resize(N); for( auto& v : a ) v = vec4(bench_rand(),bench_rand(),bench_rand(),bench_rand()); }
+		for( int k=0; k < 2; k++ )
+		{
+			m3[k].resize(N); m4[k].resize(N); m43[k].resize(N);
+			for( size_t i=0; i < N; i++ )	// distinct inputs for k=0 and k=1, so a*b never multiplies a matrix by its copy
+			{
+				size_t j = k ? N-1-i : i;
+				m4[k][i] = mat4::translate(v3[k][i])*mat4::rotate(v3[k+1][i].normalize(),f[j])*mat4::scale(vec3(f[(j+N/2)%N]));
+				m3[k][i] = mat3(m4[k][i]);
+				m43[k][i] = mat4x3(m4[k][i]);
+			}
+		}
+	}
+};
+
+//*************************************
+// results are written to output arrays and folded into a checksum,
+// so that the optimizer cannot drop the measured work
+template <class T> struct output { std::vector<T> v = std::vector<T>(N); };
+static volatile float checksum = 0;
+template <class T> void fold( const std::vector<T>& v ){ float s=0; for( auto& x : v ) s += reinterpret_cast<const float*>(&x)[0]; checksum = checksum+s; }
+
+int main( int argc, char* argv[] )
+{
+	const char *save_path=nullptr, *baseline_path=nullptr;
+	double threshold = 0.15;
+	for( int k=1; k < argc; k++ )
+	{
+		if(strcmp(argv[k],"--save")==0&&k+1<argc)				save_path = argv[++k];
+		else if(strcmp(argv[k],"--baseline")==0&&k+1<argc)		baseline_path = argv[++k];
+		else if(strcmp(argv[k],"--threshold")==0&&k+1<argc)	threshold = atof(argv[++k]);
+		else { printf( "usage: %s [--save file] [--baseline file] [--threshold fraction]\n", argv[0] ); return 1; }
+	}
+
+	// load the baseline first: the gate fails when it is missing
+	std::map<std::string,double> baseline;
+	if(baseline_path)
+	{
+		FILE* fp = fopen( baseline_path, "r" ); if(!fp){ printf( "[error] no baseline at %s; run make bench_math_save first\n", baseline_path ); return 1; }
+		char line[256], name[128]; double ns;
+		while(fgets(line,sizeof(line),fp)) if(line[0]!='#'&&sscanf(line,"%127s %lf",name,&ns)==2) baseline[name]=ns;
+		fclose(fp);
+	}
+	auto over = [&]( const char* name, double ns ){ auto it=baseline.find(name); return it!=baseline.end()&&ns/it->second-1.0>threshold; };
+
+	inputs in;
+	output<float> of; output<vec2> o2; output<vec3> o3; output<vec4> o4;
+	output<mat3> om3; output<mat4> om4; output<mat4x3> om43;
+	bench_timer timer;
+	std::vector<kernel_result> results;
+
+	printf( "[bench_math] %s %s\n", BENCH_COMPILER, BENCH_OPT );
+	bench_timer::warm_up();
+	auto run = [&]( const char* name, auto f, auto& o )
+	{
+		double ns = DBL_MAX;
+		for( int k=0; k <= RETRIES && (k==0||save_path||over(name,ns)); k++ ) ns = min(ns,timer.ns_per_op( f, N ));
+		fold( o.v );
+		results.push_back({ name, ns });
+		printf( "%-20s %9.3f ns/op %10.2f M ops/s\n", name, ns, 1e3/ns );
+	};
+
+	// vector arithmetic
+	run( "vec2.madd",		[&](){ for( size_t i=0; i < N; i++ ) o2.v[i] = in.v2[0][i]*in.v2[1][i]+in.v2[0][i]; }, o2 );
+	run( "vec3.madd",		[&](){ for( size_t i=0; i < N; i++ ) o3.v[i] = in.v3[0][i]*in.v3[1][i]+in.v3[2][i]; }, o3 );
+	run( "vec4.madd",		[&](){ for( size_t i=0; i < N; i++ ) o4.v[i] = in.v4[0][i]*in.v4[1][i]+in.v4[0][i]; }, o4 );
+	run( "vec3.dot",		[&](){ for( size_t i=0; i < N; i++ ) of.v[i] = dot(in.v3[0][i],in.v3[1][i]); }, of );
+	run( "vec3.cross",		[&](){ for( size_t i=0; i < N; i++ ) o3.v[i] = cross(in.v3[0][i],in.v3[1][i]); }, o3 );
+	run( "vec2.length",		[&](){ for( size_t i=0; i < N; i++ ) of.v[i] = length(in.v2[0][i]); }, of );
+	run( "vec3.length",		[&](){ for( size_t i=0; i < N; i++ ) of.v[i] = length(in.v3[0][i]); }, of );
+	run( "vec4.length",		[&](){ for( size_t i=0; i < N; i++ ) of.v[i] = length(in.v4[0][i]); }, of );
+	run( "vec2.normalize",	[&](){ for( size_t i=0; i < N; i++ ) o2.v[i] = normalize(in.v2[0][i]); }, o2 );
+	run( "vec3.normalize",	[&](){ for( size_t i=0; i < N; i++ ) o3.v[i] = normalize(in.v3[0][i]); }, o3 );
+	run( "vec4.normalize",	[&](){ for( size_t i=0; i < N; i++ ) o4.v[i] = normalize(in.v4[0][i]); }, o4 );
+
+	// matrix products
+	run( "mat3*vec3",		[&](){ for( size_t i=0; i < N; i++ ) o3.v[i] = in.m3[0][i]*in.v3[0][i]; }, o3 );
+	run( "mat4*vec4",		[&](){ for( size_t i=0; i < N; i++ ) o4.v[i] = in.m4[0][i]*in.v4[0][i]; }, o4 );
+	run( "mat3*mat3",		[&](){ for( size_t i=0; i < N; i++ ) om3.v[i] = in.m3[0][i]*in.m3[1][i]; }, om3 );
+	run( "mat4*mat4",		[&](){ for( size_t i=0; i < N; i++ ) om4.v[i] = in.m4[0][i]*in.m4[1][i]; }, om4 );
+	run( "mat4x3*mat4x3",	[&](){ for( size_t i=0; i < N; i++ ) om43.v[i] = in.m43[0][i]*in.m43[1][i]; }, om43 );
+
+	// inverses
+	run( "mat3.inverse",	[&](){ for( size_t i=0; i < N; i++ ) om3.v[i] = in.m3[0][i].inverse(); }, om3 );
+	run( "mat4.inverse",	[&](){ for( size_t i=0; i < N; i++ ) om4.v[i] = in.m4[0][i].inverse(); }, om4 );
+	run( "mat4x3.inverse",	[&](){ for( size_t i=0; i < N; i++ ) om43.v[i] = in.m43[0][i].inverse(); }, om43 );
+
+	// transformation builders
+	run( "mat4.look_at",	[&](){ for( size_t i=0; i < N; i++ ) om4.v[i] = mat4::look_at(in.v3[0][i],in.v3[1][i],vec3(0,1,0)); }, om4 );
+	run( "mat4.perspective",[&](){ for( size_t i=0; i < N; i++ ) om4.v[i] = mat4::perspective(in.f[i]*0.5f,in.f[i],1.0f,1000.0f); }, om4 );
+	run( "mat4.set_rotate",	[&](){ for( size_t i=0; i < N; i++ ) om4.v[i].set_rotate(in.v3[2][i],in.f[i]); }, om4 );
+
+	// save the current results as a new baseline
+	if(save_path)
+	{
+		FILE* fp = fopen( save_path, "w" ); if(!fp){ printf( "[error] unable to write %s\n", save_path ); return 1; }
+		fprintf( fp, "# %s %s\n", BENCH_COMPILER, BENCH_OPT );
+		for( auto& r : results ) fprintf( fp, "%s %.4f\n", r.name.c_str(), r.ns );
+		fclose(fp);
+		printf( "> baseline saved to %s\n", save_path );
+	}
+
+	// compare against the stored baseline
+	if(baseline_path)
+	{
+		int regressions = 0;
+		printf( "> comparing with %s (threshold %+.0f%%)\n", baseline_path, threshold*100.0 );
+		for( auto& r : results )
+		{
+			if(!over(r.name.c_str(),r.ns)) continue;
+			auto it = baseline.find(r.name); double change = r.ns/it->second-1.0;
+			printf( "[regression] %-20s %9.3f ns/op vs %9.3f ns/op (%+.1f%%)\n", r.name.c_str(), r.ns, it->second, change*100.0 );
+			regressions++;
+		}
+		if(regressions){ printf( "> %d kernel(s) regressed\n", regressions ); return 1; }
+		printf( "> no regression\n" );
+	}
+
+	return 0;
+}
@@ -0,0 +1,58 @@
+#include "workpool.h"	// include before cgmath.h, which defines min/max macros
+#include "bench.h"
+#include "nbody.h"
+
+//*************************************
+// barnes-hut disk: force error against theta=0 (every leaf summed directly), energy
+// drift of the leapfrog, and the cost of a step with one thread and with all of them
+// - the step is split into the tree build and the rest, which runs in parallel_for();
+//   counting the whole build as serial bounds the step on p cores from above (Amdahl)
+// usage: bench_nbody [count=100000]
+struct nbody_probe : nbody_system { using nbody_system::build_tree; };	// to time the tree build alone
+static nbody_desc disk( uint count, float theta ){ return { count, 20, 120, 2, 1e5f, 1e4f, 0.5f, theta, 0.02f, 0.1f, vec3(1) }; }
+
+int main( int argc, char* argv[] )
+{
+	size_t count = argc>1 ? size_t(atoll(argv[1])) : 100000;
+	bench_timer timer; timer.trials = 3; timer.min_seconds = 0.2;
+	work_pool pool, serial(1);
+	printf( "[bench_nbody] %s %s, %zu bodies, %u threads\n", BENCH_COMPILER, BENCH_OPT, count, pool.size() );
+
+	// force error against the direct sum; the sorted order is the same for every theta
+	nbody_system exact; exact.create( disk(20000,0) ); exact.compute_forces( serial );
+	for( float theta : { 0.3f, 0.5f, 0.7f } )
+	{
+		nbody_system s; s.create( disk(20000,theta) ); s.compute_forces( serial );
+		std::vector<double> e(s.size());
+		for( size_t k=0; k < s.size(); k++ )
+		{
+			vec3 a(s.ax[k],s.ay[k],s.az[k]), r(exact.ax[k],exact.ay[k],exact.az[k]);
+			e[k] = length(a-r)/length(r);
+		}
+		std::sort( e.begin(), e.end() );
+		printf( "force: theta=%.1f, relative error %.2g median, %.2g at 99%%, %.2g max (20000 bodies)\n", theta, e[e.size()/2], e[e.size()*99/100], e.back() );
+	}
+
+	// energy drift of the leapfrog over ten inner orbits
+	{
+		nbody_system s; s.create( disk(2000,0.5f) );
+		double e0 = s.energy();
+		for( int k=0; k < 2000; k++ ) s.step( serial, 1.0f/120.0f );
+		printf( "energy: relative drift %.2g after 2000 steps of 1/120 (2000 bodies)\n", (s.energy()-e0)/std::abs(e0) );
+	}
+
+	// a full step: tree, forces, and the two kicks and the drift; Project3 defaults to 20000 bodies
+	for( size_t n : { size_t(20000), count } )
+	{
+		nbody_probe s; s.create( disk(uint(n),0.7f) );
+		double ms1 = timer.ns_per_op( [&](){ s.step( serial, 1.0f/120.0f ); }, 1 )*1e-6;
+		double msn = timer.ns_per_op( [&](){ s.step( pool, 1.0f/120.0f ); }, 1 )*1e-6;
+		double ms_tree = timer.ns_per_op( [&](){ s.build_tree( serial ); }, 1 )*1e-6;
+		printf( "step: %zu bodies, %.2f ms with 1 thread (%.2f ms tree), %.2f ms with %u threads (theta=0.7, %zu nodes, %zu groups)\n", n, ms1, ms_tree, msn, pool.size(), s.nodes.size(), s.groups.size() );
+		printf( "      upper bound with the tree serial:" );
+		for( uint p : { 1u, 2u, 4u, 8u, 16u } ) printf( " %.1f ms on %u%s", ms_tree+(ms1-ms_tree)/p, p, p<16?",":" cores\n" );
+		if(n==count) break;
+	}
+
+	return 0;
+}
@@ -0,0 +1,71 @@
+#include <functional>	// include before cgmath.h, which defines min/max macros
+#include "bench.h"
+#include "scene.h"
+
+//*************************************
+// dirty-flag propagation of the flat scene graph
+// - a solar system with belts: roots, orbits, and many small leaves, as in Project3
+// - the cached world transforms are checked against walking up each parent chain in double
+static dmat4 reference_local( const scene_trs& l ){ return dmat4::translate(l.translation)*dmat4(l.linear_matrix()); }
+static dmat4 reference_world( const scene_graph& s, int k )
+{
+	dmat4 m = reference_local(s.local[k]);
+	for( int p=s.parent[k]; p>=0; p=s.parent[p] ) m = reference_local(s.local[p])*m;
+	return m;
+}
+
+static double max_error( const scene_graph& s )
+{
+	double e = 0;
+	for( int k=0; k < int(s.size()); k++ )
+	{
+		dmat4 r = reference_world(s,k), w = dmat4(s.world[k]);
+		dvec3 t = r.translation(); w._14=t.x-s.world_position[k].x; w._24=t.y-s.world_position[k].y; w._34=t.z-s.world_position[k].z;
+		r._14=r._24=r._34=0;
+		for( int i=0; i < 16; i++ ) e = max(e,std::abs(r[i]-w[i]));
+	}
+	return e;
+}
+
+static volatile size_t sink = 0;
+
+int main( int argc, char* argv[] )
+{
+	size_t count = argc>1 ? size_t(atoll(argv[1])) : 100000;
+	bench_timer timer;
+
+	// a sun, planets, moons, and belts of small bodies under a few orbit nodes
+	srand(0);
+	scene_graph s;
+	int sun = s.add(-1);
+	std::vector<int> orbits;
+	for( int k=0; k < 8; k++ ){ scene_trs o; o.translation=dvec3(20.0+10*k,0,0); o.angle=bench_rand(0,PI); orbits.push_back(s.add(sun,o)); }
+	for( int k=0; k < 16; k++ ){ scene_trs o; o.translation=dvec3(bench_rand(2,6),0,0); orbits.push_back(s.add(orbits[k%8],o)); }
+	while( s.size() < count )
+	{
+		scene_trs a; a.translation=dvec3(bench_rand(-5,5),bench_rand(-0.5f,0.5f),bench_rand(-5,5)); a.axis=vec3(bench_rand(),bench_rand(),bench_rand()).normalize(); a.angle=bench_rand(0,PI); a.scale=vec3(bench_rand(0.01f,0.1f));
+		s.add( orbits[rand()%orbits.size()], a );
+	}
+	size_t n = s.update();
+	printf( "[bench_scene] %s %s, %zu nodes\n", BENCH_COMPILER, BENCH_OPT, s.size() );
+	printf( "max error against the parent-chain reference: %.3g (%zu nodes recomputed)\n", max_error(s), n );
+
+	// one leaf of 100 that moves, one orbit with its subtree, every node, and nothing
+	std::vector<int> leaves; for( int k=0; k < int(s.size()); k+=100 ) leaves.push_back(int(s.size())-1-k);
+	struct { const char* name; std::function<void()> edit; } cases[] = {
+		{ "1% leaves", [&](){ for( int k : leaves ) s.edit(k).angle+=0.01f; } },
+		{ "one orbit subtree", [&](){ s.edit(orbits[3]).angle+=0.01f; } },
+		{ "all nodes", [&](){ for( int k=0; k < int(s.size()); k++ ) s.edit(k).angle+=0.01f; } },
+		{ "nothing dirty", [&](){} },
+	};
+	printf( "%-20s %10s %12s %12s\n", "edit", "nodes", "update", "per node" );
+	for( auto& c : cases )
+	{
+		c.edit(); n = s.update();
+		double ns = timer.ns_per_op( [&](){ c.edit(); sink = sink+s.update(); }, 1 );
+		printf( "%-20s %10zu %9.3f ms %9.2f ns\n", c.name, n, ns*1e-6, n ? ns/double(n) : 0.0 );
+	}
+	printf( "max error after the edits: %.3g\n", max_error(s) );
+
+	return 0;
+}
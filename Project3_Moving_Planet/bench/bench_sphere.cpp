@@ -0,0 +1,120 @@
+#include "bench.h"
+#include "sphere.h"
+
+//*************************************
+// reference: the per-vertex trigonometry with push_back growth that sphere.h replaces
+static std::vector<vertex> reference_sphere_vertices( uint N )
+{
+	std::vector<vertex> v = { { vec3(0), vec3(0,0,-1.0f), vec2(0.5f) } };
+	for( uint i=0; i <= N; i++ )
+	{
+		for( uint j=0; j <= N/2; j++ )
+		{
+			float t = PI * 2.0f * j / float(N), tc = cos(t), ts = sin(t);
+			float p = PI * 2.0f * i / float(N), pc = cos(p), ps = sin(p);
+			v.push_back({ vec3(ts * ps, tc, ts * pc), vec3(ts * pc, ts * ps, tc), vec2(p / (2.0f * PI), 1.0f - (t / PI)) });
+		}
+	}
+	return v;
+}
+
+static std::vector<uint> reference_sphere_indices( uint N )
+{
+	std::vector<uint> indices;
+	for( uint i=0; i < N; i++ )
+	{
+		for( uint j=0; j < N/2; j++ )
+		{
+			indices.push_back(i * (N / 2 + 1) + j + 1);
+			indices.push_back(i * (N / 2 + 1) + j + 2);
+			indices.push_back((i + 1) * (N / 2 + 1) + j + 2);
+			indices.push_back(i * (N / 2 + 1) + j + 1);
+			indices.push_back((i + 1) * (N / 2 + 1) + j + 2);
+			indices.push_back((i + 1) * (N / 2 + 1) + j + 1);
+		}
+	}
+	return indices;
+}
+
+static volatile size_t sink = 0;
+
+//*************************************
+// geometric error of a tessellated unit sphere: the largest gap between the sphere
+// and a triangle plane, as a fraction of the radius (times the radius in pixels,
+// this is the silhouette error in pixels); degenerate pole triangles are skipped
+struct quality
+{
+	size_t	vertices, triangles;
+	double	error;
+	bool	front_facing;
+};
+
+static quality measure( const std::vector<vertex>& v, const std::vector<uint>& indices, size_t vertices )
+{
+	quality q = { vertices, indices.size()/3, 0, true };
+	for( size_t k=0; k < indices.size(); k+=3 )
+	{
+		dvec3 a=dvec3(v[indices[k]].pos), b=dvec3(v[indices[k+1]].pos), c=dvec3(v[indices[k+2]].pos);
+		if(length(b-a)<1e-6||length(c-b)<1e-6||length(a-c)<1e-6) continue;
+		dvec3 n = cross(b-a,c-a); double l=length(n);
+		double d = dot(n,a)/l; if(d<=0) q.front_facing=false;
+		q.error = max(q.error,1.0-d);
+	}
+	return q;
+}
+
+static quality uv_quality( uint N ){ return measure(create_sphere_vertices(N,true),create_sphere_indices(N),size_t(N+1)*(N/2+1)); }
+static quality ico_quality( uint level ){ auto m=create_icosphere(level,true); return measure(m.vertices,m.indices,m.vertices.size()); }
+static quality cube_quality( uint N ){ auto m=create_cubesphere(N,true); return measure(m.vertices,m.indices,m.vertices.size()); }
+
+// the smallest parameter in [lo,hi] meeting the error target (error decreases with the parameter)
+template <class F> uint smallest_for( F f, double target, uint lo, uint hi, uint step=1 )
+{
+	while(lo<hi){ uint m=(lo/step+hi/step)/2*step; if(f(m).error<=target) hi=m; else lo=m+step; }
+	return lo;
+}
+
+int main( int argc, char* argv[] )
+{
+	printf( "[bench_sphere] %s %s\n", BENCH_COMPILER, BENCH_OPT );
+
+	// the tessellator must reproduce the reference mesh exactly
+	for( uint N : { 4u, 71u, 72u, 256u } )
+	{
+		auto v0 = reference_sphere_vertices(N), v1 = create_sphere_vertices(N,true);
+		auto i0 = reference_sphere_indices(N), i1 = create_sphere_indices(N);
+		if(v0.size()!=v1.size()||memcmp(v0.data(),v1.data(),sizeof(vertex)*v0.size())!=0){ printf( "[error] vertices differ at N=%u\n", N ); return 1; }
+		if(i0!=i1){ printf( "[error] indices differ at N=%u\n", N ); return 1; }
+	}
+
+	// triangle count against geometric error
+	printf( "\n%-14s %10s %10s %12s %10s\n", "mesh", "vertices", "triangles", "error", "time" );
+	bench_timer timer; timer.trials = 3;
+	auto row = [&]( const char* name, uint param, quality q, double ms )
+	{
+		if(!q.front_facing){ printf( "[error] %s(%u) has back-facing triangles\n", name, param ); exit(1); }
+		printf( "%-8s %5u %10zu %10zu %12.3e %7.3f ms\n", name, param, q.vertices, q.triangles, q.error, ms );
+	};
+	for( uint N : { 16u, 32u, 64u, 128u, 256u } )	row( "uv", N, uv_quality(N), timer.ns_per_op([&](){ sink = sink+create_sphere_vertices(N,true).size()+create_sphere_indices(N).size(); },1)*1e-6 );
+	for( uint l : { 1u, 2u, 3u, 4u, 5u, 6u } )		row( "ico", l, ico_quality(l), timer.ns_per_op([&](){ sink = sink+create_icosphere(l,true).indices.size(); },1)*1e-6 );
+	for( uint N : { 4u, 8u, 16u, 32u, 64u } )		row( "cube", N, cube_quality(N), timer.ns_per_op([&](){ sink = sink+create_cubesphere(N,true).indices.size(); },1)*1e-6 );
+
+	// the cheapest mesh of each kind for a target silhouette quality
+	printf( "\n%-10s %22s %22s %22s\n", "error <=", "uv (N) tris", "ico (level) tris", "cube (N) tris" );
+	for( double target : { 1e-2, 1e-3, 1e-4 } )
+	{
+		uint nu = smallest_for( uv_quality, target, 4, 2048, 2 ), li = smallest_for( ico_quality, target, 0, 8 ), nc = smallest_for( cube_quality, target, 1, 512 );
+		printf( "%-10.0e %8u %13zu %8u %13zu %8u %13zu\n", target, nu, uv_quality(nu).triangles, li, ico_quality(li).triangles, nc, cube_quality(nc).triangles );
+	}
+
+	printf( "\n%-8s %10s %14s %14s %8s\n", "N", "vertices", "reference", "sphere.h", "speedup" );
+	for( uint N : { 72u, 512u, 1024u, 4096u } )
+	{
+		size_t nv = 1+size_t(N+1)*(N/2+1);
+		double ref = timer.ns_per_op( [&](){ sink = sink+reference_sphere_vertices(N).size()+reference_sphere_indices(N).size(); }, nv );
+		double cur = timer.ns_per_op( [&](){ sink = sink+create_sphere_vertices(N,true).size()+create_sphere_indices(N).size(); }, nv );
+		printf( "%-8u %10zu %11.2f ms %11.2f ms %7.1fx\n", N, nv, ref*nv*1e-6, cur*nv*1e-6, ref/cur );
+	}
+
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include "bench.h"
+#include "sphere.h"
+#include "meshopt.h"
+
+//*************************************
+// triangle strips with primitive restart against triangle lists of the uv sphere
+// - index memory is what every draw submits to the vertex pulling stage
+// - ACMR of strips is measured on the triangles they expand to
+static std::vector<uint> strip_to_list( const std::vector<uint>& strip )
+{
+	std::vector<uint> list;
+	for( size_t k=0, n=0; k < strip.size(); k++ )
+	{
+		if(strip[k]==SPHERE_RESTART_INDEX){ n=0; continue; }
+		if(++n<3) continue;
+		uint a=strip[k-2], b=strip[k-1], c=strip[k];
+		if(n%2) list.insert(list.end(),{a,b,c}); else list.insert(list.end(),{b,a,c}); // odd triangles flip
+	}
+	return list;
+}
+
+// triangles as rotation-invariant keys, to compare two index buffers
+static std::vector<std::array<uint,3>> triangle_set( const std::vector<uint>& list )
+{
+	std::vector<std::array<uint,3>> s;
+	for( size_t k=0; k < list.size(); k+=3 )
+	{
+		uint a=list[k], b=list[k+1], c=list[k+2];
+		if(b<a&&b<c) s.push_back({b,c,a}); else if(c<a&&c<b) s.push_back({c,a,b}); else s.push_back({a,b,c});
+	}
+	std::sort(s.begin(),s.end());
+	return s;
+}
+
+static volatile size_t sink = 0;
+
+int main( int argc, char* argv[] )
+{
+	printf( "[bench_strip] %s %s\n", BENCH_COMPILER, BENCH_OPT );
+	printf( "%-6s %9s %9s %6s %10s %10s %10s %10s %9s %9s %9s\n", "N", "list", "strip", "ratio", "list KB", "strip KB", "list gen", "strip gen", "acmr", "acmr opt", "acmr str" );
+
+	bench_timer timer; timer.trials = 3;
+	for( uint N : { 32u, 72u, 256u, 1024u } )
+	{
+		std::vector<uint> list = create_sphere_indices(N), strip = create_sphere_strip_indices(N);
+		size_t nv = 1+size_t(N+1)*(N/2+1);
+		if(triangle_set(list)!=triangle_set(strip_to_list(strip))){ printf( "[error] strips differ from the list at N=%u\n", N ); return 1; }
+
+		// 16-bit indices when the restart index 0xffff is not a vertex
+		size_t index_size = nv<65535 ? sizeof(ushort) : sizeof(uint);
+		double tl = timer.ns_per_op( [&](){ sink = sink+create_sphere_indices(N).size(); }, 1 );
+		double ts = timer.ns_per_op( [&](){ sink = sink+create_sphere_strip_indices(N).size(); }, 1 );
+
+		std::vector<uint> opt = list; optimize_vertex_cache( opt, nv );
+		printf( "%-6u %9zu %9zu %6.3f %10.1f %10.1f %7.3f ms %7.3f ms %9.3f %9.3f %9.3f\n", N, list.size(), strip.size(), double(strip.size())/double(list.size()),
+			list.size()*index_size/1024.0, strip.size()*index_size/1024.0, tl*1e-6, ts*1e-6,
+			analyze_vertex_cache(list,nv).acmr, analyze_vertex_cache(opt,nv).acmr, analyze_vertex_cache(strip_to_list(strip),nv).acmr );
+	}
+
+	return 0;
+}
@@ -0,0 +1,39 @@
+#include "bench.h"
+#include "sphere.h"
+#include "meshopt.h"
+
+//*************************************
+// ACMR/ATVR and vertex fetch report of the generated meshes before and after optimization
+// usage: bench_vcache [cache_size=16]
+static void report( const char* name, std::vector<vertex> vertices, std::vector<uint> indices, uint cache_size )
+{
+	size_t nv = vertices.size();
+	vcache_stats s0 = analyze_vertex_cache( indices, nv, cache_size );
+	float f0 = analyze_vertex_fetch( indices, nv, sizeof(vertex) );
+
+	auto t0 = std::chrono::high_resolution_clock::now();
+	optimize_vertex_cache( indices, nv );
+	auto t1 = std::chrono::high_resolution_clock::now();
+	optimize_vertex_fetch( vertices, indices );
+	auto t2 = std::chrono::high_resolution_clock::now();
+
+	vcache_stats s1 = analyze_vertex_cache( indices, nv, cache_size );
+	float f1 = analyze_vertex_fetch( indices, nv, sizeof(vertex) );
+	printf( "%-10s %8zu %6.3f > %5.3f %6.3f > %5.3f %6.3f > %5.3f %8.2f ms %7.2f ms\n", name, indices.size()/3,
+		s0.acmr, s1.acmr, s0.atvr, s1.atvr, f0, f1,
+		std::chrono::duration<double,std::milli>(t1-t0).count(), std::chrono::duration<double,std::milli>(t2-t1).count() );
+}
+
+int main( int argc, char* argv[] )
+{
+	uint cache_size = argc>1 ? uint(atoi(argv[1])) : 16;
+	printf( "[bench_vcache] %s %s, FIFO cache of %u vertices\n", BENCH_COMPILER, BENCH_OPT, cache_size );
+	printf( "%-10s %8s %14s %14s %14s %11s %10s\n", "mesh", "tris", "acmr", "atvr", "overfetch", "vcache", "vfetch" );
+
+	char name[32];
+	for( uint N : { 32u, 72u, 256u } ){ snprintf( name, sizeof(name), "uv%u", N ); report( name, create_sphere_vertices(N,true), create_sphere_indices(N), cache_size ); }
+	for( uint l : { 3u, 5u } ){ sphere_mesh m=create_icosphere(l,true); snprintf( name, sizeof(name), "ico%u", l ); report( name, m.vertices, m.indices, cache_size ); }
+	for( uint N : { 16u, 64u } ){ sphere_mesh m=create_cubesphere(N,true); snprintf( name, sizeof(name), "cube%u", N ); report( name, m.vertices, m.indices, cache_size ); }
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+#include "bench.h"
+
+//*************************************
+// usage: test_cgmath [count] [seed]
+// - checks algebraic properties of cgmath.h on random well-conditioned inputs,
+//   and that the SIMD/rewritten kernels return exactly what their scalar forms return
+// - prints the worst error of every check and fails (exit code 1) when any exceeds its tolerance
+static int failures = 0;
+
+static void expect( const char* name, double err, double tol )
+{
+	bool ok = err<=tol; if(!ok) failures++;
+	printf( "%-48s error %10.3g (tolerance %.1g) %s\n", name, err, tol, ok?"ok":"FAILED" );
+}
+
+//*************************************
+// random inputs: unit axes, angles, and TRS matrices with scales in [0.5,2]
+static vec3 rand_axis(){ for(;;){ vec3 v(bench_rand(),bench_rand(),bench_rand()); if(v.length()>0.1f) return v.normalize(); } }
+static float rand_angle(){ return bench_rand(-PI,PI); }
+static mat4 rand_trs(){ return mat4::translate(vec3(bench_rand(-10,10),bench_rand(-10,10),bench_rand(-10,10)))*mat4::rotate(rand_axis(),rand_angle())*mat4::scale(vec3(bench_rand(0.5f,2.0f),bench_rand(0.5f,2.0f),bench_rand(0.5f,2.0f))); }
+static dmat4 rand_dtrs(){ return dmat4::translate(dvec3(bench_rand(-1e6f,1e6f),bench_rand(-1e6f,1e6f),bench_rand(-1e6f,1e6f)))*dmat4::rotate(dvec3(rand_axis()).normalize(),rand_angle())*dmat4::scale(dvec3(bench_rand(0.5f,2.0f),bench_rand(0.5f,2.0f),bench_rand(0.5f,2.0f))); }
+
+// max |a[k]-b[k]| over the elements
+template <class M> double max_diff( const M& a, const M& b, size_t n ){ double e=0; for( size_t k=0; k < n; k++ ) e=max(e,std::abs(double(a[k])-double(b[k]))); return e; }
+static double orthonormality( const mat3& r ){ return max_diff(r*r.transpose(),mat3(),9); }
+static double orthonormality( const dmat4& r ){ dmat4 u=r; u._14=u._24=u._34=0; return max_diff(u*u.transpose(),dmat4(),16); }
+static double rel( double a, double b ){ return std::abs(a-b)/max(std::abs(b),1e-30); }
+static vec3 xyz( const vec4& v ){ return vec3(v.x,v.y,v.z); }
+
+//*************************************
+// scalar forms of today's kernels, written out in the same summation order
+static mat4 ref_product( const mat4& a, const mat4& b ){ mat4 r; for( int i=0; i<4; i++ ) for( int j=0; j<4; j++ ) r[i*4+j]=a[i*4]*b[j]+a[i*4+1]*b[4+j]+a[i*4+2]*b[8+j]+a[i*4+3]*b[12+j]; return r; }
+static mat4x3 ref_product( const mat4x3& a, const mat4x3& b ){ mat4x3 r; for( int i=0; i<3; i++ ) for( int j=0; j<4; j++ ) r[i*4+j]=a[i*4]*b[j]+a[i*4+1]*b[4+j]+a[i*4+2]*b[8+j]+(j==3?a[i*4+3]:0.0f); return r; }
+static vec4 ref_product( const mat4& a, const vec4& v ){ return vec4(a._11*v.x+a._12*v.y+a._13*v.z+a._14*v.w, a._21*v.x+a._22*v.y+a._23*v.z+a._24*v.w, a._31*v.x+a._32*v.y+a._33*v.z+a._34*v.w, a._41*v.x+a._42*v.y+a._43*v.z+a._44*v.w); }
+template <class M> size_t mismatches( const M& a, const M& b, size_t n ){ size_t m=0; for( size_t k=0; k < n; k++ ) m+=a[k]!=b[k]; return m; }
+
+int main( int argc, char* argv[] )
+{
+	size_t count = argc>1 ? size_t(atoll(argv[1])) : 10000;
+	srand( argc>2 ? uint(atoi(argv[2])) : 0 );
+	printf( "[test_cgmath] %s %s, %zu samples\n", BENCH_COMPILER, BENCH_OPT, count );
+
+	// inverses and determinants
+	double e_inv3=0, e_inv4=0, e_inv43=0, e_dinv4=0, e_det3=0, e_det4=0, e_det43=0, e_ddet4=0;
+	for( size_t k=0; k < count; k++ )
+	{
+		mat4 a=rand_trs(), b=rand_trs(); mat3 a3=mat3(a), b3=mat3(b); mat4x3 a43=mat4x3(a), b43=mat4x3(b);
+		dmat4 da=rand_dtrs(), db=rand_dtrs();
+		e_inv3 = max(e_inv3,max_diff(a3.inverse()*a3,mat3(),9));
+		e_inv4 = max(e_inv4,max_diff(a.inverse()*a,mat4(),16));
+		e_inv43 = max(e_inv43,max_diff(a43.inverse()*a43,mat4x3(),12));
+		e_dinv4 = max(e_dinv4,max_diff(da.inverse()*da,dmat4(),16));
+		e_det3 = max(e_det3,rel((a3*b3).det(),double(a3.det())*b3.det()));
+		e_det4 = max(e_det4,rel((a*b).det(),double(a.det())*b.det()));
+		e_det43 = max(e_det43,rel((a43*b43).det(),double(a43.det())*b43.det()));
+		e_ddet4 = max(e_ddet4,rel((da*db).det(),da.det()*db.det()));
+	}
+	expect( "mat3 inverse(m)*m == I", e_inv3, 1e-5 );
+	expect( "mat4 inverse(m)*m == I", e_inv4, 2e-5 );
+	expect( "mat4x3 inverse(m)*m == I", e_inv43, 1e-5 );
+	expect( "dmat4 inverse(m)*m == I", e_dinv4, 1e-8 );	// translations up to 1e6
+	expect( "mat3 det(ab) == det(a)det(b)", e_det3, 1e-5 );
+	expect( "mat4 det(ab) == det(a)det(b)", e_det4, 1e-5 );
+	expect( "mat4x3 det(ab) == det(a)det(b)", e_det43, 1e-5 );
+	expect( "dmat4 det(ab) == det(a)det(b)", e_ddet4, 1e-13 );
+
+	// rotations, look_at, and quaternions
+	double e_rot4=0, e_rot43=0, e_drot4=0, e_rdet=0, e_look=0, e_dlook=0, e_eye=0, e_qmat=0, e_qvec=0, e_qmul=0, e_qint=0;
+	for( size_t k=0; k < count; k++ )
+	{
+		vec3 axis=rand_axis(), axis2=rand_axis(); float angle=rand_angle(), angle2=rand_angle();
+		mat4 r=mat4::rotate(axis,angle);
+		e_rot4 = max(e_rot4,orthonormality(mat3(r)));
+		e_rot43 = max(e_rot43,orthonormality(mat3(mat4x3::rotate(axis,angle))));
+		e_drot4 = max(e_drot4,orthonormality(dmat4::rotate(dvec3(axis).normalize(),angle)));
+		e_rdet = max(e_rdet,std::abs(r.det()-1.0));
+
+		vec3 eye(bench_rand(-100,100),bench_rand(-100,100),bench_rand(-100,100)), at(bench_rand(-10,10),bench_rand(-10,10),bench_rand(-10,10));
+		if((eye-at).normalize().cross(axis).length()<0.1f) continue; // up should not be parallel to the view direction
+		mat4 v=mat4::look_at(eye,at,axis);
+		e_look = max(e_look,orthonormality(mat3(v)));
+		e_dlook = max(e_dlook,orthonormality(dmat4::look_at(dvec3(eye),dvec3(at),dvec3(axis).normalize())));
+		e_eye = max(e_eye,double(xyz(v*vec4(eye,1.0f)).length())/eye.length());	// the eye maps to the origin
+
+		quat q=quat::rotate(axis,angle), q2=quat::rotate(axis2,angle2);
+		vec3 p(bench_rand(),bench_rand(),bench_rand());
+		e_qmat = max(e_qmat,max_diff(mat3(q),mat3(r),9));
+		e_qvec = max(e_qvec,double((q*p-xyz(r*vec4(p,0.0f))).length()));
+		e_qmul = max(e_qmul,max_diff(mat3(q*q2),mat3(r)*mat3(mat4::rotate(axis2,angle2)),9));
+		vec3 omega=axis*bench_rand(0.1f,10.0f); double dt=bench_rand(0,1);
+		e_qint = max(e_qint,max_diff(mat3(quat().integrate(omega,dt)),mat3(mat4::rotate(axis,float(omega.length()*dt))),9));
+	}
+	expect( "mat4::rotate orthonormal", e_rot4, 2e-6 );
+	expect( "mat4x3::rotate orthonormal", e_rot43, 2e-6 );
+	expect( "dmat4::rotate orthonormal", e_drot4, 1e-14 );
+	expect( "mat4::rotate det == 1", e_rdet, 2e-6 );
+	expect( "mat4::look_at orthonormal", e_look, 2e-6 );
+	expect( "dmat4::look_at orthonormal", e_dlook, 1e-14 );
+	expect( "mat4::look_at eye -> origin", e_eye, 1e-6 );
+	expect( "mat3(quat) == mat4::rotate", e_qmat, 2e-6 );
+	expect( "quat*v == mat4::rotate*v", e_qvec, 2e-6 );
+	expect( "mat3(q*q2) == mat3(q)*mat3(q2)", e_qmul, 2e-6 );
+	expect( "quat::integrate == mat4::rotate", e_qint, 1e-5 );
+
+	// exact: the kernels against their scalar forms, and mat4x3 against mat4
+	size_t x_prod4=0, x_prod43=0, x_vec4=0, x_embed=0, x_point=0;
+	for( size_t k=0; k < count; k++ )
+	{
+		mat4 a=rand_trs(), b=rand_trs(); mat4x3 a43=mat4x3(a), b43=mat4x3(b);
+		vec4 v(bench_rand(),bench_rand(),bench_rand(),bench_rand()); vec3 p(v.x,v.y,v.z);
+		x_prod4 += mismatches(a*b,ref_product(a,b),16);
+		x_prod43 += mismatches(a43*b43,ref_product(a43,b43),12);
+		x_vec4 += mismatches(a*v,ref_product(a,v),4);
+		x_embed += mismatches(mat4(a43*b43),mat4(a43)*mat4(b43),16);
+		x_point += mismatches(a43.transform_point(p),xyz(mat4(a43)*vec4(p,1.0f)),3);
+	}
+	expect( "mat4*mat4 == scalar, mismatches", double(x_prod4), 0 );
+	expect( "mat4x3*mat4x3 == scalar, mismatches", double(x_prod43), 0 );
+	expect( "mat4*vec4 == scalar, mismatches", double(x_vec4), 0 );
+	expect( "mat4x3*mat4x3 == mat4*mat4, mismatches", double(x_embed), 0 );
+	expect( "transform_point == mat4*vec4, mismatches", double(x_point), 0 );
+
+	// batched culling against the single-object tests; the SIMD path sums the plane terms in
+	// another order, so only objects within 1e-3 of a plane may differ
+	mat4 view_projection = mat4::perspective( PI/4.0f, 16/9.0f, 1.0f, 1000.0f )*mat4::look_at( vec3(0,100,200), vec3(0), vec3(0,1,0) );
+	frustum f( view_projection );
+	std::vector<sphere3> spheres(count|3); std::vector<aabb3> boxes(spheres.size()); std::vector<uchar> visible(spheres.size());
+	for( size_t k=0; k < spheres.size(); k++ ){ spheres[k]=sphere3(vec3(bench_rand(-500,500),bench_rand(-200,200),bench_rand(-500,500)),bench_rand(0.1f,10.0f)); boxes[k]=aabb3(spheres[k]); }
+	size_t x_sphere=0, x_box=0;
+	f.cull( spheres.data(), spheres.size(), visible.data() );
+	for( size_t k=0; k < spheres.size(); k++ )
+	{
+		if(bool(visible[k])==f.intersects(spheres[k])) continue;
+		float margin=FLT_MAX; for( auto& p : f.p ) margin=min(margin,std::abs(p.distance(spheres[k].center)+spheres[k].radius));
+		x_sphere += margin>1e-3f;
+	}
+	f.cull( boxes.data(), boxes.size(), visible.data() );
+	for( size_t k=0; k < boxes.size(); k++ )
+	{
+		if(bool(visible[k])==f.intersects(boxes[k])) continue;
+		float margin=FLT_MAX; for( auto& p : f.p ) margin=min(margin,std::abs(p.distance(boxes[k].center())+fabs(p.n).dot(boxes[k].extent())));
+		x_box += margin>1e-3f;
+	}
+	expect( "frustum::cull(sphere3) == intersects, mismatches", double(x_sphere), 0 );
+	expect( "frustum::cull(aabb3) == intersects, mismatches", double(x_box), 0 );
+
+	// fast_sincos: the documented bound over several periods
+	double e_sin=0, e_cos=0;
+	for( size_t k=0; k < count; k++ )
+	{
+		float a=bench_rand(-1000,1000), s, c; fast_sincos(a,s,c);
+		e_sin = max(e_sin,std::abs(s-sin(double(a))));
+		e_cos = max(e_cos,std::abs(c-cos(double(a))));
+	}
+	expect( "fast_sincos sin", e_sin, 4e-6 );
+	expect( "fast_sincos cos", e_cos, 4e-6 );
+
+	printf( "%d check(s) failed\n", failures );
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+#include "workpool.h"	// include before cgmath.h, which defines min/max macros
+#include "bench.h"
+
+//*************************************
+// usage: test_workpool [count] [seed]
+// - issues count parallel_for() calls back to back, as nbody_system::step() does, on pools
+//   of 2 to 8 threads, with random sizes, grains and iteration costs so that ranges are stolen
+// - every iteration has to run exactly once per call, and every call has to return;
+//   a call that hangs is reported by a watchdog after 10 seconds without progress
+static int failures = 0;
+
+static void expect( const char* name, double err, double tol )
+{
+	bool ok = err<=tol; if(!ok) failures++;
+	printf( "%-48s error %10.3g (tolerance %.1g) %s\n", name, err, tol, ok?"ok":"FAILED" );
+}
+
+static std::atomic<size_t> progress{0};	// calls returned so far
+
+static void watchdog()
+{
+	for( size_t seen=size_t(-1);; )
+	{
+		std::this_thread::sleep_for( std::chrono::seconds(10) );
+		size_t p = progress.load(); if(p!=seen){ seen=p; continue; }
+		printf( "parallel_for() did not return for 10 seconds after %zu calls FAILED\n", p );
+		fflush( stdout ); std::_Exit( 1 );
+	}
+}
+
+int main( int argc, char* argv[] )
+{
+	size_t count = argc>1 ? size_t(atoll(argv[1])) : 5000;
+	srand( argc>2 ? uint(atoi(argv[2])) : 0 );
+	printf( "[test_workpool] %s %s, %zu calls per pool\n", BENCH_COMPILER, BENCH_OPT, count );
+	std::thread( watchdog ).detach();
+
+	std::vector<std::atomic<uint>> hits(4096);
+	for( uint threads : { 2u, 3u, 4u, 8u } )
+	{
+		work_pool pool( threads );
+		size_t missed=0, repeated=0; std::atomic<size_t> outside{0};
+		for( size_t k=0; k < count; k++ )
+		{
+			size_t n = size_t(bench_rand(0,float(hits.size()))), grain = size_t(bench_rand(1,64));
+			uint spin = k%4==0 ? uint(bench_rand(0,2000)) : 0;	// a slow prefix on some calls, to force steals
+			for( size_t i=0; i < n; i++ ) hits[i].store( 0 );
+			pool.parallel_for( n, grain, [&]( size_t begin, size_t end )
+			{
+				if(end>n||end-begin>grain) outside++;
+				for( size_t i=begin; i < end && i < n; i++ ){ hits[i].fetch_add(1); uint c=i<n/4?spin:0; for( volatile uint s=0; s < c; s++ ); }
+			});
+			progress.fetch_add(1);
+			for( size_t i=0; i < n; i++ ){ uint h=hits[i].load(); missed+=h==0; repeated+=h>1; }
+		}
+		char name[64];
+		snprintf( name, sizeof(name), "%u threads: iterations not run", threads ); expect( name, double(missed), 0 );
+		snprintf( name, sizeof(name), "%u threads: iterations run twice", threads ); expect( name, double(repeated), 0 );
+		snprintf( name, sizeof(name), "%u threads: subranges outside [0,n)", threads ); expect( name, double(outside.load()), 0 );
+	}
+
+	printf( "%d check(s) failed\n", failures );
+	return failures ? 1 : 0;
+}
@@ -8,15 +8,24 @@ precision highp float; // default precision needs to be defined
 // input
 in vec3 norm;
 in vec2 tc;
+flat in vec4 color;	// per instance
 
-// input from vertex shader
-uniform bool b_solid_color;
-uniform vec4 solid_color;
+// per-frame uniforms: frame_uniforms in main.cpp, bound once per frame
+layout(std140, row_major) uniform frame_block
+{
+	mat4	view_matrix;	// without the eye translation
+	mat4	projection_matrix;
+	mat4	view_projection_matrix;
+	vec4	viewport;		// x, y, width, and height in pixels
+	float	time;			// simulation seconds
+	bool	b_solid_color;
+	bool	b_procedural;
+};
 
 // the only output variable
 out vec4 fragColor;
 
 void main()
 {
-	fragColor = b_solid_color ? solid_color : vec4(tc.xy, 0, 1);
+	fragColor = b_solid_color ? color : vec4(tc.xy, 0, 1);
 }
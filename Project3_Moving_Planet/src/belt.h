@@ -0,0 +1,85 @@
+#pragma once
+#ifndef __BELT_H__
+#define __BELT_H__
+
+#include "cgmath.h"		// slee's simple math library
+
+//*************************************
+// belts and rings of many small bodies around a center
+// - orbital elements are kept as structure of arrays, and positions are evaluated
+//   analytically from time in one flat loop, without any per-body scene node
+// - angular speeds follow Kepler's third law (proportional to radius^-1.5), so the
+//   inner edge moves faster than the outer edge
+// - positions are relative to the center in the belt plane, tilted by the belt axis
+// - the vertical oscillation h*sin(a+node) is kept as h*cos(node) and h*sin(node), so
+//   each body needs a single sincos, which is the branch-free fast_sincos() to vectorize
+
+struct belt_desc
+{
+	const char*	name;
+	int			parent;				// body to surround; -1 for the origin
+	uint		count;				// number of bodies
+	float		inner, outer;		// radii of the edges from the center
+	float		thickness;			// vertical amplitude at the mid radius
+	float		min_size, max_size;	// radii of the bodies
+	float		speed;				// angular speed at the inner edge
+	vec3		rgb;
+	float		tilt;				// tilt angle about the x axis in radians
+};
+
+struct particle_belt
+{
+	belt_desc			desc;
+	std::vector<float>	radius, phase, speed, height_cos, height_sin;	// orbital elements
+	std::vector<float>	scale, shade;										// radius and brightness of the bodies
+	std::vector<float>	x, y, z;											// evaluated positions
+	mat4x3				tilt;
+
+	size_t size() const { return radius.size(); }
+
+	void create( const belt_desc& d, uint seed=0 )
+	{
+		desc = d; tilt = mat4x3::rotate( vec3(1,0,0), d.tilt );
+		size_t n = d.count;
+		for( auto* v : { &radius, &phase, &speed, &height_cos, &height_sin, &scale, &shade, &x, &y, &z } ) v->resize(n);
+
+		// a small LCG, so that a belt looks the same on every run and platform
+		uint s = seed*2654435761u+1u; auto rnd = [&](){ s = s*1664525u+1013904223u; return float(s>>8)/float(1<<24); };
+		float mid = (d.inner+d.outer)*0.5f;
+		for( size_t k=0; k < n; k++ )
+		{
+			float r = d.inner+(d.outer-d.inner)*(rnd()+rnd())*0.5f;	// denser at the middle
+			radius[k] = r;
+			phase[k] = rnd()*2.0f*PI;
+			speed[k] = d.speed*powf(d.inner/r,1.5f);
+			float h = d.thickness*(r/mid)*(rnd()*2.0f-1.0f), node = rnd()*2.0f*PI;
+			height_cos[k] = h*cosf(node); height_sin[k] = h*sinf(node);
+			scale[k] = d.min_size+(d.max_size-d.min_size)*rnd()*rnd();	// mostly small
+			shade[k] = 0.6f+0.4f*rnd();
+		}
+	}
+
+	// positions at time t; each body's angle w*t is reduced to [-pi,pi] in double before
+	// the cast to float, so the error does not grow with time and fast_sincos() stays in
+	// its exact range; adding and subtracting 1.5*2^52 rounds to an integer without
+	// floor(), which would need SSE4.1 to vectorize
+	void evaluate( double t )
+	{
+		const float *r=radius.data(), *p=phase.data(), *w=speed.data(), *hc=height_cos.data(), *hs=height_sin.data();
+		float *px=x.data(), *py=y.data(), *pz=z.data();
+		const float t11=tilt._11, t12=tilt._12, t13=tilt._13, t21=tilt._21, t22=tilt._22, t23=tilt._23, t31=tilt._31, t32=tilt._32, t33=tilt._33;
+		ptrdiff_t n = ptrdiff_t(size());
+		#pragma omp parallel for simd schedule(static)
+		for( ptrdiff_t k=0; k < n; k++ )
+		{
+			double a = double(w[k])*t, q = (a*(0.5/PI_D)+0x1.8p52)-0x1.8p52;
+			float s, c; fast_sincos( p[k]+float(a-q*(2.0*PI_D)), s, c );
+			float lx = r[k]*s, ly = hc[k]*s+hs[k]*c, lz = r[k]*c;	// h*sin(a+node)
+			px[k] = t11*lx+t12*ly+t13*lz;
+			py[k] = t21*lx+t22*ly+t23*lz;
+			pz[k] = t31*lx+t32*ly+t33*lz;
+		}
+	}
+};
+
+#endif // __BELT_H__
@@ -43,6 +43,11 @@
 	#include <unordered_map>
 	#include <unordered_set>
 #endif
+// SIMD intrinsics for batched tests (scalar fallback otherwise)
+#if defined(__SSE2__)||defined(_M_X64)||(defined(_M_IX86_FP)&&_M_IX86_FP>=2)
+	#include <emmintrin.h>
+	#define CGMATH_SSE2
+#endif
 // windows/GCC
 #if !defined(__GNUC__)&&(defined(_WIN32)||defined(_WIN64))
 	#ifndef NOMINMAX
@@ -64,6 +69,9 @@
 #ifndef PI
 	#define PI 3.141592653589793f
 #endif
+#ifndef PI_D // for reducing large angles in double: the float PI is off by 8.7e-8, and the error grows with every period
+	#define PI_D 3.141592653589793
+#endif
 #ifndef max
 	#define max(a,b) ((a)>(b)?(a):(b))
 #endif
@@ -109,6 +117,7 @@ template <class T> struct tvec2
 	tvec2( T a ){ x=y=a; }						inline void set( T a ){ x=y=a; }
 	tvec2( T a, T b ){ x=a;y=b; }				inline void set( T a, T b ){ x=a;y=b; }
 	tvec2( const tvec2& v ){ x=v.x;y=v.y; }		inline void set( const tvec2& v ){ x=v.x;y=v.y; }
+	template <class U> explicit tvec2( const tvec2<U>& v ){ x=T(v.x);y=T(v.y); } // precision conversion
 
 	// assignment / compound assignment operators
 	inline tvec2& operator=( T a ){ set(a); return *this; }
@@ -168,6 +177,7 @@ template <class T> struct tvec3
 	tvec3( const tvec3& v ){ x=v.x;y=v.y;z=v.z; }			inline void set( const tvec3& v ){ x=v.x;y=v.y;z=v.z; }
 	tvec3( const tvec2<T>& v, T c ){ x=v.x;y=v.y;z=c; }		inline void set( const tvec2<T>& v, T c ){ x=v.x;y=v.y;z=c; }
 	tvec3( T a, const tvec2<T>& v ){ x=a;y=v.x;z=v.y; }		inline void set( T a, const tvec2<T>& v ){ x=a;y=v.x;z=v.y; }
+	template <class U> explicit tvec3( const tvec3<U>& v ){ x=T(v.x);y=T(v.y);z=T(v.z); } // precision conversion
 
 	// assignment / compound assignment operators
 	inline tvec3& operator=( T a ){ set(a); return *this; }
@@ -233,6 +243,7 @@ template <class T> struct tvec4
 	tvec4( const tvec3<T>& v, T d ){ x=v.x;y=v.y;z=v.z;w=d; }		inline void set( const tvec3<T>& v, T d ){ x=v.x;y=v.y;z=v.z;w=d; }
 	tvec4( T a, const tvec3<T>& v ){ x=a;y=v.x;z=v.y;w=v.z; }		inline void set( T a, const tvec3<T>& v ){ x=a;y=v.x;z=v.y;w=v.z; }
 	tvec4( const tvec2<T>& v1, const tvec2<T>& v2 ){ x=v1.x;y=v1.y;z=v2.x;w=v2.y; }
+	template <class U> explicit tvec4( const tvec4<U>& v ){ x=T(v.x);y=T(v.y);z=T(v.z);w=T(v.w); } // precision conversion
 	inline void set( const tvec2<T>& v1, const tvec2<T>& v2 ){ x=v1.x;y=v1.y;z=v2.x;w=v2.y; }
 
 	// assignment / compound assignment operators
@@ -484,6 +495,255 @@ inline mat4 mat4::inverse() const
 				(_21*_32*_13 - _31*_22*_13 + _31*_12*_23 - _11*_32*_23 - _21*_12*_33 + _11*_22*_33)*s );
 }
 
+//*******************************************************************
+// affine matrix 3x4: mat4 without the implicit last row (0,0,0,1)
+// - uses the same row-major notation as mat4 (48 bytes instead of 64)
+// - upload with glUniformMatrix4x3fv(uloc,1,GL_TRUE,m) to GLSL mat4x3
+struct mat4x3
+{
+	union { float a[12]; struct {float _11,_12,_13,_14,_21,_22,_23,_24,_31,_32,_33,_34;}; };
+
+	mat4x3(){ _12=_13=_14=_21=_23=_24=_31=_32=_34=0.0f;_11=_22=_33=1.0f; }
+	mat4x3( float f11, float f12, float f13, float f14, float f21, float f22, float f23, float f24, float f31, float f32, float f33, float f34 ){_11=f11;_12=f12;_13=f13;_14=f14;_21=f21;_22=f22;_23=f23;_24=f24;_31=f31;_32=f32;_33=f33;_34=f34;}
+	explicit mat4x3( const mat4& m ){ memcpy( a, m.a, sizeof(a) ); } // drops the last row
+
+	// comparison operators
+	inline bool operator==( const mat4x3& m ) const { for( size_t k=0; k<std::extent<decltype(a)>::value; k++ ) if(std::abs(a[k]-m[k])>precision<float>::value()) return false; return true; }
+	inline bool operator!=( const mat4x3& m ) const { return !operator==(m); }
+
+	// casting operators
+	inline operator float*(){ return a; }
+	inline operator const float*() const { return a; }
+	inline operator mat3() const { return mat3(_11, _12, _13, _21, _22, _23, _31, _32, _33 ); }
+	inline operator mat4() const { return mat4(_11, _12, _13, _14, _21, _22, _23, _24, _31, _32, _33, _34, 0, 0, 0, 1.0f ); }
+
+	// array access operators
+	inline float& operator[]( ptrdiff_t i ){ return a[i]; }
+	inline const float& operator[]( ptrdiff_t i ) const { return a[i]; }
+	inline float& at( ptrdiff_t i ){ return a[i]; }
+	inline const float& at( ptrdiff_t i ) const { return a[i]; }
+
+	// row vectors and translation
+	inline vec4& rvec4( int row ){ return reinterpret_cast<vec4&>(a[row*4]); }
+	inline vec3& rvec3( int row ){ return reinterpret_cast<vec3&>(a[row*4]); }
+	inline const vec4& rvec4( int row ) const { return reinterpret_cast<const vec4&>(a[row*4]); }
+	inline const vec3& rvec3( int row ) const { return reinterpret_cast<const vec3&>(a[row*4]); }
+	inline vec3 translation() const { return vec3(_14,_24,_34); }
+
+	// identity
+	static mat4x3 identity(){ return mat4x3(); }
+	inline mat4x3& set_identity(){ _12=_13=_14=_21=_23=_24=_31=_32=_34=0.0f;_11=_22=_33=1.0f; return *this; }
+
+	// multiplication operators: 36 mul for the affine product instead of 64
+	inline vec3 operator*( const vec4& v ) const { return vec3(rvec4(0).dot(v), rvec4(1).dot(v), rvec4(2).dot(v)); }
+	inline vec3 transform_point( const vec3& v ) const { return vec3(_11*v.x+_12*v.y+_13*v.z+_14, _21*v.x+_22*v.y+_23*v.z+_24, _31*v.x+_32*v.y+_33*v.z+_34); }
+	inline vec3 transform_vector( const vec3& v ) const { return vec3(_11*v.x+_12*v.y+_13*v.z, _21*v.x+_22*v.y+_23*v.z, _31*v.x+_32*v.y+_33*v.z); }
+	// each row of the product is a combination of the rows of m: r[k] = a[k][0]*m[0]+a[k][1]*m[1]+a[k][2]*m[2]+(0,0,0,a[k][3]),
+	// which maps to four-wide multiply-adds; the summation order is the same in both paths, so the results are identical
+	inline mat4x3 operator*( const mat4x3& m ) const
+	{
+		mat4x3 r;
+#ifdef CGMATH_SSE2
+		__m128 m0=_mm_loadu_ps(m.a), m1=_mm_loadu_ps(m.a+4), m2=_mm_loadu_ps(m.a+8);
+		for( int k=0; k < 3; k++ )
+		{
+			const float* s=a+k*4;
+			__m128 t=_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(s[0]),m0),_mm_mul_ps(_mm_set1_ps(s[1]),m1)),_mm_mul_ps(_mm_set1_ps(s[2]),m2));
+			_mm_storeu_ps( r.a+k*4, _mm_add_ps(t,_mm_setr_ps(0,0,0,s[3])) );
+		}
+#else
+		for( int k=0; k < 3; k++ ) for( int j=0; j < 4; j++ ) r.a[k*4+j] = a[k*4]*m.a[j]+a[k*4+1]*m.a[4+j]+a[k*4+2]*m.a[8+j]+(j==3?a[k*4+3]:0.0f);
+#endif
+		return r;
+	}
+	inline mat4x3& operator*=( const mat4x3& m ){ return *this=operator*(m); }
+
+	// determinant and inverse: only the upper-left 3x3 needs a real inversion
+	inline float det() const { return _11*(_22*_33-_23*_32) + _12*(_23*_31-_21*_33) + _13*(_21*_32-_22*_31); }
+	inline mat4x3 inverse() const
+	{
+		float d=det(), s=1.0f/d; if(d==0) printf( "mat4x3::inverse() might be singular.\n" );
+		float i11=(_22*_33-_32*_23)*s, i12=(_13*_32-_12*_33)*s, i13=(_12*_23-_13*_22)*s;
+		float i21=(_23*_31-_21*_33)*s, i22=(_11*_33-_13*_31)*s, i23=(_21*_13-_11*_23)*s;
+		float i31=(_21*_32-_31*_22)*s, i32=(_31*_12-_11*_32)*s, i33=(_11*_22-_21*_12)*s;
+		return mat4x3(	i11, i12, i13, -(i11*_14+i12*_24+i13*_34),
+						i21, i22, i23, -(i21*_14+i22*_24+i23*_34),
+						i31, i32, i33, -(i31*_14+i32*_24+i33*_34) );
+	}
+
+	// static row-major transformations
+	static mat4x3 translate( const vec3& v ){ return mat4x3().set_translate(v); }
+	static mat4x3 translate( float x, float y, float z ){ return mat4x3().set_translate(x,y,z); }
+	static mat4x3 scale( const vec3& v ){ return mat4x3().set_scale(v); }
+	static mat4x3 scale( float x, float y, float z ){ return mat4x3().set_scale(x,y,z); }
+	static mat4x3 scale( float s ){ return mat4x3().set_scale(s,s,s); }
+	static mat4x3 rotate( const vec3& axis, float angle ){ return mat4x3().set_rotate(axis,angle); }
+
+	// row-major transformations
+	inline mat4x3& set_translate( const vec3& v ){ set_identity(); _14=v.x; _24=v.y; _34=v.z; return *this; }
+	inline mat4x3& set_translate( float x,float y,float z ){ set_identity(); _14=x; _24=y; _34=z; return *this; }
+	inline mat4x3& set_scale( const vec3& v ){ set_identity(); _11=v.x; _22=v.y; _33=v.z; return *this; }
+	inline mat4x3& set_scale( float x, float y, float z ){ set_identity(); _11=x; _22=y; _33=z; return *this; }
+	inline mat4x3& set_rotate( const vec3& axis, float angle ){ memcpy( a, mat4().set_rotate(axis,angle).a, sizeof(a) ); return *this; }
+};
+
+// mixed mat4-affine products, e.g., view_projection_matrix*model_matrix
+inline mat4 operator*( const mat4& m, const mat4x3& b ){ return m*mat4(b); }
+inline mat4 operator*( const mat4x3& b, const mat4& m ){ return mat4(b)*m; }
+
+//*******************************************************************
+// double-precision matrix 4x4: uses the same row-major notation as mat4
+// - keeps large-scale world transforms in double; see rte_model_matrix()
+struct dmat4
+{
+	union { double a[16]; struct {double _11,_12,_13,_14,_21,_22,_23,_24,_31,_32,_33,_34,_41,_42,_43,_44;}; };
+
+	dmat4(){ _12=_13=_14=_21=_23=_24=_31=_32=_34=_41=_42=_43=0.0;_11=_22=_33=_44=1.0; }
+	dmat4( double f11, double f12, double f13, double f14, double f21, double f22, double f23, double f24, double f31, double f32, double f33, double f34, double f41, double f42, double f43, double f44 ){_11=f11;_12=f12;_13=f13;_14=f14;_21=f21;_22=f22;_23=f23;_24=f24;_31=f31;_32=f32;_33=f33;_34=f34;_41=f41;_42=f42;_43=f43;_44=f44;}
+	explicit dmat4( const mat4& m ){ for( size_t k=0; k<std::extent<decltype(a)>::value; k++ ) a[k]=m[k]; }
+	explicit dmat4( const mat4x3& m ){ for( size_t k=0; k<12; k++ ) a[k]=m[k]; _41=_42=_43=0.0; _44=1.0; }
+
+	// comparison operators
+	inline bool operator==( const dmat4& m ) const { for( size_t k=0; k<std::extent<decltype(a)>::value; k++ ) if(std::abs(a[k]-m[k])>precision<double>::value()) return false; return true; }
+	inline bool operator!=( const dmat4& m ) const { return !operator==(m); }
+
+	// casting operators: float conversion should happen as late as possible
+	inline operator double*(){ return a; }
+	inline operator const double*() const { return a; }
+	explicit inline operator mat4() const { mat4 m; for( size_t k=0; k<std::extent<decltype(a)>::value; k++ ) m[k]=float(a[k]); return m; }
+
+	// array access operators
+	inline double& operator[]( ptrdiff_t i ){ return a[i]; }
+	inline const double& operator[]( ptrdiff_t i ) const { return a[i]; }
+	inline double& at( ptrdiff_t i ){ return a[i]; }
+	inline const double& at( ptrdiff_t i ) const { return a[i]; }
+
+	// row vectors and translation
+	inline dvec4& rvec4( int row ){ return reinterpret_cast<dvec4&>(a[row*4]); }
+	inline const dvec4& rvec4( int row ) const { return reinterpret_cast<const dvec4&>(a[row*4]); }
+	inline dvec3 translation() const { return dvec3(_14,_24,_34); }
+
+	// identity and transpose
+	static dmat4 identity(){ return dmat4(); }
+	inline dmat4& set_identity(){ return *this=dmat4(); }
+	inline dmat4 transpose() const { return dmat4(_11, _21, _31, _41, _12, _22, _32, _42, _13, _23, _33, _43, _14, _24, _34, _44); }
+
+	// multiplication operators
+	inline dmat4 operator*( double f ) const { dmat4 r; for( size_t k=0; k < std::extent<decltype(a)>::value; k++ ) r[k]=a[k]*f; return r; }
+	inline dvec4 operator*( const dvec4& v ) const { return dvec4(rvec4(0).dot(v), rvec4(1).dot(v), rvec4(2).dot(v), rvec4(3).dot(v)); }
+	inline dmat4 operator*( const dmat4& m ) const { dmat4 r; for( int i=0; i<4; i++ ) for( int j=0; j<4; j++ ) r[i*4+j]=a[i*4]*m[j]+a[i*4+1]*m[4+j]+a[i*4+2]*m[8+j]+a[i*4+3]*m[12+j]; return r; }
+	inline dmat4& operator*=( const dmat4& m ){ return *this=operator*(m); }
+
+	// determinant and inverse via 2x2 sub-determinants
+	inline double det() const
+	{
+		double s0=_11*_22-_21*_12, s1=_11*_23-_21*_13, s2=_11*_24-_21*_14, s3=_12*_23-_22*_13, s4=_12*_24-_22*_14, s5=_13*_24-_23*_14;
+		double c0=_31*_42-_41*_32, c1=_31*_43-_41*_33, c2=_31*_44-_41*_34, c3=_32*_43-_42*_33, c4=_32*_44-_42*_34, c5=_33*_44-_43*_34;
+		return s0*c5-s1*c4+s2*c3+s3*c2-s4*c1+s5*c0;
+	}
+	inline dmat4 inverse() const
+	{
+		double s0=_11*_22-_21*_12, s1=_11*_23-_21*_13, s2=_11*_24-_21*_14, s3=_12*_23-_22*_13, s4=_12*_24-_22*_14, s5=_13*_24-_23*_14;
+		double c0=_31*_42-_41*_32, c1=_31*_43-_41*_33, c2=_31*_44-_41*_34, c3=_32*_43-_42*_33, c4=_32*_44-_42*_34, c5=_33*_44-_43*_34;
+		double d=s0*c5-s1*c4+s2*c3+s3*c2-s4*c1+s5*c0, s=1.0/d; if(d==0) printf( "dmat4::inverse() might be singular.\n" );
+		return dmat4(	( _22*c5-_23*c4+_24*c3)*s, (-_12*c5+_13*c4-_14*c3)*s, ( _42*s5-_43*s4+_44*s3)*s, (-_32*s5+_33*s4-_34*s3)*s,
+						(-_21*c5+_23*c2-_24*c1)*s, ( _11*c5-_13*c2+_14*c1)*s, (-_41*s5+_43*s2-_44*s1)*s, ( _31*s5-_33*s2+_34*s1)*s,
+						( _21*c4-_22*c2+_24*c0)*s, (-_11*c4+_12*c2-_14*c0)*s, ( _41*s4-_42*s2+_44*s0)*s, (-_31*s4+_32*s2-_34*s0)*s,
+						(-_21*c3+_22*c1-_23*c0)*s, ( _11*c3-_12*c1+_13*c0)*s, (-_41*s3+_42*s1-_43*s0)*s, ( _31*s3-_32*s1+_33*s0)*s );
+	}
+
+	// static row-major transformations
+	static dmat4 translate( const dvec3& v ){ dmat4 m; m._14=v.x; m._24=v.y; m._34=v.z; return m; }
+	static dmat4 translate( double x, double y, double z ){ return translate(dvec3(x,y,z)); }
+	static dmat4 scale( const dvec3& v ){ dmat4 m; m._11=v.x; m._22=v.y; m._33=v.z; return m; }
+	static dmat4 scale( double x, double y, double z ){ return scale(dvec3(x,y,z)); }
+	static dmat4 rotate( const dvec3& axis, double angle )
+	{
+		double c=cos(angle), s=sin(angle), x=axis.x, y=axis.y, z=axis.z;
+		return dmat4(	x*x*(1-c)+c,	x*y*(1-c)-z*s,	x*z*(1-c)+y*s,	0,
+						x*y*(1-c)+z*s,	y*y*(1-c)+c,	y*z*(1-c)-x*s,	0,
+						x*z*(1-c)-y*s,	y*z*(1-c)+x*s,	z*z*(1-c)+c,	0,
+						0,				0,				0,				1.0 );
+	}
+	static dmat4 look_at( const dvec3& eye, const dvec3& at, const dvec3& up )
+	{
+		dvec3 n = (eye-at).normalize(), u = up.cross(n).normalize(), v = n.cross(u).normalize();
+		return dmat4(	u.x, u.y, u.z, -u.dot(eye),
+						v.x, v.y, v.z, -v.dot(eye),
+						n.x, n.y, n.z, -n.dot(eye),
+						0,	 0,	  0,   1.0 );
+	}
+};
+
+//*******************************************************************
+// unit quaternion (x,y,z: vector part, w: scalar part) for orientations
+// - composes like matrices: (a*b) rotates by b first, and then by a
+// - integrate() applies an angular velocity in the world frame exactly for a constant
+//   velocity, so rotations about several axes at once cost the same as one
+// - convert with mat3()/mat4x3() when building a model matrix
+struct quat
+{
+	float x=0, y=0, z=0, w=1;
+
+	quat() = default;
+	quat( float x, float y, float z, float w ):x(x),y(y),z(z),w(w){}
+
+	// comparison operators
+	inline bool operator==( const quat& q ) const { return std::abs(x-q.x)<=precision<float>::value()&&std::abs(y-q.y)<=precision<float>::value()&&std::abs(z-q.z)<=precision<float>::value()&&std::abs(w-q.w)<=precision<float>::value(); }
+	inline bool operator!=( const quat& q ) const { return !operator==(q); }
+
+	// identity, conjugate, and normalization
+	static quat identity(){ return quat(); }
+	inline quat conjugate() const { return quat(-x,-y,-z,w); }	// the inverse of a unit quaternion
+	inline float length() const { return sqrtf(x*x+y*y+z*z+w*w); }
+	inline quat normalize() const { float s=1.0f/length(); return quat(x*s,y*s,z*s,w*s); }
+
+	// multiplication operators (Hamilton product) and rotation of a vector
+	inline quat operator*( const quat& q ) const { return quat( w*q.x+x*q.w+y*q.z-z*q.y, w*q.y-x*q.z+y*q.w+z*q.x, w*q.z+x*q.y-y*q.x+z*q.w, w*q.w-x*q.x-y*q.y-z*q.z ); }
+	inline quat& operator*=( const quat& q ){ return *this=operator*(q); }
+	inline vec3 operator*( const vec3& v ) const { vec3 u(x,y,z), t=u.cross(v)*2.0f; return v+t*w+u.cross(t); }
+
+	// rotation by angle (in radian) about a unit axis: the same rotation as mat4::rotate()
+	static quat rotate( const vec3& axis, float angle ){ float s=sinf(angle*0.5f); return quat(axis.x*s,axis.y*s,axis.z*s,cosf(angle*0.5f)); }
+
+	// rotates by a world-frame angular velocity omega (radians per second) over dt seconds;
+	// the angle is reduced in double, so large steps (e.g., fast-forwarded time) stay precise
+	inline quat& integrate( const vec3& omega, double dt )
+	{
+		float l=omega.length(); if(l==0||dt==0) return *this;
+		return *this=(rotate(omega*(1.0f/l),float(fmod(double(l)*dt,4.0*PI_D)))*(*this)).normalize();	// renormalized against the drift of repeated products
+	}
+
+	// casting to rotation matrices
+	inline operator mat3() const
+	{
+		float xx=x*x, yy=y*y, zz=z*z, xy=x*y, xz=x*z, yz=y*z, wx=w*x, wy=w*y, wz=w*z;
+		return mat3( 1-2*(yy+zz), 2*(xy-wz), 2*(xz+wy), 2*(xy+wz), 1-2*(xx+zz), 2*(yz-wx), 2*(xz-wy), 2*(yz+wx), 1-2*(xx+yy) );
+	}
+	inline operator mat4x3() const { mat3 m=operator mat3(); return mat4x3( m._11, m._12, m._13, 0, m._21, m._22, m._23, 0, m._31, m._32, m._33, 0 ); }
+};
+
+//*******************************************************************
+// camera-relative rendering for large-scale scenes
+// - world positions are kept in double; the eye is subtracted in double, and
+//   only the small eye-relative offsets are converted to float for the GPU
+// - pair with rte_view_matrix(), which drops the eye translation of the view
+// - keep the eye itself in double (e.g., camera::eye); recovering it by inverting a float
+//   view matrix would round it before the subtraction and defeat the purpose
+inline mat4 rte_view_matrix( const mat4& view_matrix ){ mat4 v=view_matrix; v._14=v._24=v._34=0.0f; return v; }
+inline mat4x3 rte_model_matrix( const dmat4& model_matrix, const dvec3& eye )
+{
+	mat4x3 m; for( size_t k=0; k<12; k++ ) m[k]=float(model_matrix[k]);
+	m._14=float(model_matrix._14-eye.x); m._24=float(model_matrix._24-eye.y); m._34=float(model_matrix._34-eye.z);
+	return m;
+}
+inline mat4x3 rte_model_matrix( const dvec3& world_position, const mat4x3& local_matrix, const dvec3& eye ) // translate(world_position)*local_matrix
+{
+	mat4x3 m=local_matrix;
+	m._14=float(world_position.x-eye.x+m._14); m._24=float(world_position.y-eye.y+m._24); m._34=float(world_position.z-eye.z+m._34);
+	return m;
+}
+
 //*******************************************************************
 // scalar-vector operators
 inline vec2 operator+( float f, const vec2& v ){ return v+f; }
@@ -494,6 +754,7 @@ inline vec3 operator-( float f, const vec3& v ){ return -v+f; }
 inline vec4 operator-( float f, const vec4& v ){ return -v+f; }
 inline vec2 operator*( float f, const vec2& v ){ return v*f; }
 inline vec3 operator*( float f, const vec3& v ){ return v*f; }
+inline dvec3 operator*( double f, const dvec3& v ){ return v*f; }
 inline vec4 operator*( float f, const vec4& v ){ return v*f; }
 
 //*******************************************************************
@@ -508,6 +769,10 @@ inline float dot( const vec2& v1, const vec2& v2){ return v1.dot(v2); }
 inline float dot( const vec3& v1, const vec3& v2){ return v1.dot(v2); }
 inline float dot( const vec4& v1, const vec4& v2){ return v1.dot(v2); }
 inline vec3 cross( const vec3& v1, const vec3& v2){ return v1.cross(v2); }
+inline double dot( const dvec3& v1, const dvec3& v2){ return v1.dot(v2); }
+inline dvec3 cross( const dvec3& v1, const dvec3& v2){ return v1.cross(v2); }
+inline double length( const dvec3& v ){ return v.length(); }
+inline dvec3 normalize( const dvec3& v ){ return v.normalize(); }
 
 //*******************************************************************
 // utility math functions
@@ -569,4 +834,205 @@ inline vec2 smootherstep( const vec2& t ){ return vec2(smootherstep(t.x),smoothe
 inline vec3 smootherstep( const vec3& t ){ return vec3(smootherstep(t.x),smootherstep(t.y),smootherstep(t.z)); }
 inline vec4 smootherstep( const vec4& t ){ return vec4(smootherstep(t.x),smootherstep(t.y),smootherstep(t.z),smootherstep(t.w)); }
 
+// octahedral encoding of unit vectors into [-1,1]^2: the upper/lower hemispheres fold onto the
+// inner/outer diamonds of the square, so two quantized components keep a near-uniform precision
+inline vec2 oct_encode( const vec3& n ){ float s=1.0f/(fabs(n.x)+fabs(n.y)+fabs(n.z)); vec2 e(n.x*s,n.y*s); return n.z>=0?e:vec2((1.0f-fabs(e.y))*(e.x>=0?1.0f:-1.0f),(1.0f-fabs(e.x))*(e.y>=0?1.0f:-1.0f)); }
+inline vec3 oct_decode( const vec2& e ){ vec3 n(e.x,e.y,1.0f-fabs(e.x)-fabs(e.y)); if(n.z<0){ n.x=(1.0f-fabs(e.y))*(e.x>=0?1.0f:-1.0f); n.y=(1.0f-fabs(e.x))*(e.y>=0?1.0f:-1.0f); } return n.normalize(); }
+
+// sin/cos with |error| < 4e-6 and no branches, so loops over it vectorize: two-constant
+// reduction to [-pi,pi], a reflection to [-pi/2,pi/2], and Taylor polynomials of degree 9 (sin) and 10 (cos)
+inline void fast_sincos( float a, float& s, float& c )
+{
+	const float C1 = 6.28125f, C2 = 1.9353071795864769253e-3f;	// 2*PI = C1+C2; q*C1 is exact for |q| < 2^15
+	float q = float(int(a*(0.5f/PI)+copysignf(0.5f,a)));
+	float x = (a-q*C1)-q*C2;
+	float fold = fabsf(x)>0.5f*PI ? 1.0f : 0.0f;					// reflect: r = sign(x)*PI-x
+	float r = x+fold*(copysignf(PI,x)-2.0f*x), sign = 1.0f-2.0f*fold;
+	float r2 = r*r;
+	s = r*(1.0f+r2*(-1.0f/6.0f+r2*(1.0f/120.0f+r2*(-1.0f/5040.0f+r2*(1.0f/362880.0f)))));
+	c = sign*(1.0f+r2*(-0.5f+r2*(1.0f/24.0f+r2*(-1.0f/720.0f+r2*(1.0f/40320.0f-r2*(1.0f/3628800.0f))))));
+}
+
+//*******************************************************************
+// plane: n.dot(p)+d=0 with a unit normal n
+struct plane
+{
+	vec3	n = vec3(0,1.0f,0);
+	float	d = 0;
+
+	plane(){}
+	plane( const vec3& normal, float offset ){ n=normal; d=offset; }
+	plane( const vec3& normal, const vec3& p ){ n=normal; d=-normal.dot(p); }
+	explicit plane( const vec4& v ){ float s=1.0f/vec3(v.x,v.y,v.z).length(); n=vec3(v.x,v.y,v.z)*s; d=v.w*s; } // normalizes (a,b,c,d)
+
+	inline float distance( const vec3& p ) const { return n.dot(p)+d; } // signed distance
+};
+
+//*******************************************************************
+// bounding sphere: 16 bytes, so that four of them transpose into SIMD registers
+struct sphere3
+{
+	vec3	center;
+	float	radius = 0;
+
+	sphere3(){}
+	sphere3( const vec3& c, float r ){ center=c; radius=r; }
+
+	inline bool contains( const vec3& p ) const { return (p-center).length2()<=radius*radius; }
+	inline bool intersects( const sphere3& s ) const { float r=radius+s.radius; return (s.center-center).length2()<=r*r; }
+	inline bool intersects( const plane& p ) const { return std::abs(p.distance(center))<=radius; }
+	inline bool intersect_ray( const vec3& origin, const vec3& dir, float* t=nullptr ) const // for picking; dir needs to be normalized
+	{
+		vec3 o=origin-center; float b=o.dot(dir), c=o.length2()-radius*radius, h=b*b-c; if(h<0) return false;
+		h=sqrtf(h); float t0=-b-h, t1=-b+h; if(t1<0) return false;
+		if(t){ *t=t0>=0?t0:t1; } return true;
+	}
+};
+
+//*******************************************************************
+// axis-aligned bounding box; empty (inverted) by default
+struct aabb3
+{
+	vec3	pmin = vec3(FLT_MAX);
+	vec3	pmax = vec3(-FLT_MAX);
+
+	aabb3(){}
+	aabb3( const vec3& p0, const vec3& p1 ){ pmin=p0; pmax=p1; }
+	explicit aabb3( const sphere3& s ){ pmin=s.center-s.radius; pmax=s.center+s.radius; }
+
+	inline bool empty() const { return pmin.x>pmax.x||pmin.y>pmax.y||pmin.z>pmax.z; }
+	inline vec3 center() const { return (pmin+pmax)*0.5f; }
+	inline vec3 extent() const { return (pmax-pmin)*0.5f; } // half size
+	inline aabb3& expand( const vec3& p ){ pmin=vec3(min(pmin.x,p.x),min(pmin.y,p.y),min(pmin.z,p.z)); pmax=vec3(max(pmax.x,p.x),max(pmax.y,p.y),max(pmax.z,p.z)); return *this; }
+	inline aabb3& expand( const aabb3& b ){ return b.empty()?*this:expand(b.pmin).expand(b.pmax); }
+	inline bool contains( const vec3& p ) const { return p.x>=pmin.x&&p.x<=pmax.x&&p.y>=pmin.y&&p.y<=pmax.y&&p.z>=pmin.z&&p.z<=pmax.z; }
+	inline bool intersects( const aabb3& b ) const { return pmin.x<=b.pmax.x&&b.pmin.x<=pmax.x&&pmin.y<=b.pmax.y&&b.pmin.y<=pmax.y&&pmin.z<=b.pmax.z&&b.pmin.z<=pmax.z; }
+	inline bool intersects( const sphere3& s ) const { vec3 c=vec3(clamp(s.center.x,pmin.x,pmax.x),clamp(s.center.y,pmin.y,pmax.y),clamp(s.center.z,pmin.z,pmax.z)); return s.contains(c); }
+	inline operator sphere3() const { return sphere3(center(),extent().length()); }
+};
+
+//*******************************************************************
+// view frustum: six inward-facing planes (left, right, bottom, top, near, far)
+// - extracted from a row-major view-projection matrix with GL clip space
+struct frustum
+{
+	plane	p[6];
+
+	frustum(){}
+	explicit frustum( const mat4& view_projection ){ set(view_projection); }
+
+	inline frustum& set( const mat4& m )
+	{
+		const vec4 &r0=m.rvec4(0), &r1=m.rvec4(1), &r2=m.rvec4(2), &r3=m.rvec4(3);
+		p[0]=plane(r3+r0); p[1]=plane(r3-r0);
+		p[2]=plane(r3+r1); p[3]=plane(r3-r1);
+		p[4]=plane(r3+r2); p[5]=plane(r3-r2);
+		return *this;
+	}
+
+	// single-object tests: conservative, i.e., false only when fully outside a plane
+	inline bool intersects( const sphere3& s ) const { for( int k=0; k<6; k++ ) if(p[k].distance(s.center)<-s.radius) return false; return true; }
+	inline bool intersects( const aabb3& b ) const
+	{
+		vec3 c=b.center(), e=b.extent();
+		for( int k=0; k<6; k++ ) if(p[k].distance(c)+fabs(p[k].n).dot(e)<0) return false;
+		return true;
+	}
+
+	// batched tests: write 1/0 per object to visible and return the number of visible objects
+	inline size_t cull( const sphere3* s, size_t count, uchar* visible ) const;
+	inline size_t cull( const aabb3* b, size_t count, uchar* visible ) const;
+};
+
+inline size_t frustum::cull( const sphere3* s, size_t count, uchar* visible ) const
+{
+	static_assert(sizeof(sphere3)==sizeof(float)*4, "sphere3 should be tightly packed for SIMD loads");
+	size_t k=0, n=0;
+#ifdef CGMATH_SSE2
+	// four spheres per iteration: load (x,y,z,r) rows and transpose into x4,y4,z4,r4
+	__m128 px[6], py[6], pz[6], pd[6], zero=_mm_setzero_ps();
+	for( int j=0; j<6; j++ ){ px[j]=_mm_set1_ps(p[j].n.x); py[j]=_mm_set1_ps(p[j].n.y); pz[j]=_mm_set1_ps(p[j].n.z); pd[j]=_mm_set1_ps(p[j].d); }
+	for( ; k+4<=count; k+=4 )
+	{
+		__m128 x=_mm_loadu_ps(&s[k].center.x), y=_mm_loadu_ps(&s[k+1].center.x), z=_mm_loadu_ps(&s[k+2].center.x), r=_mm_loadu_ps(&s[k+3].center.x);
+		_MM_TRANSPOSE4_PS(x,y,z,r);
+		__m128 in=_mm_cmpeq_ps(zero,zero);
+		for( int j=0; j<6; j++ )
+		{
+			__m128 dist=_mm_add_ps(_mm_add_ps(_mm_mul_ps(x,px[j]),_mm_mul_ps(y,py[j])),_mm_add_ps(_mm_mul_ps(z,pz[j]),pd[j]));
+			in=_mm_and_ps(in,_mm_cmpge_ps(_mm_add_ps(dist,r),zero));
+		}
+		int mask=_mm_movemask_ps(in);
+		for( int i=0; i<4; i++ ) n+=(visible[k+i]=uchar((mask>>i)&1));
+	}
+#endif
+	for( ; k<count; k++ ) n+=(visible[k]=intersects(s[k])?1:0);
+	return n;
+}
+
+inline size_t frustum::cull( const aabb3* b, size_t count, uchar* visible ) const
+{
+	size_t k=0, n=0;
+#ifdef CGMATH_SSE2
+	// four boxes per iteration in center-extent form
+	__m128 px[6], py[6], pz[6], ax[6], ay[6], az[6], pd[6], zero=_mm_setzero_ps(), half=_mm_set1_ps(0.5f);
+	for( int j=0; j<6; j++ )
+	{
+		px[j]=_mm_set1_ps(p[j].n.x); py[j]=_mm_set1_ps(p[j].n.y); pz[j]=_mm_set1_ps(p[j].n.z); pd[j]=_mm_set1_ps(p[j].d);
+		ax[j]=_mm_set1_ps(std::abs(p[j].n.x)); ay[j]=_mm_set1_ps(std::abs(p[j].n.y)); az[j]=_mm_set1_ps(std::abs(p[j].n.z));
+	}
+	for( ; k+4<=count; k+=4 )
+	{
+		const aabb3 *b0=b+k, *b1=b+k+1, *b2=b+k+2, *b3=b+k+3;
+		__m128 x0=_mm_setr_ps(b0->pmin.x,b1->pmin.x,b2->pmin.x,b3->pmin.x), x1=_mm_setr_ps(b0->pmax.x,b1->pmax.x,b2->pmax.x,b3->pmax.x);
+		__m128 y0=_mm_setr_ps(b0->pmin.y,b1->pmin.y,b2->pmin.y,b3->pmin.y), y1=_mm_setr_ps(b0->pmax.y,b1->pmax.y,b2->pmax.y,b3->pmax.y);
+		__m128 z0=_mm_setr_ps(b0->pmin.z,b1->pmin.z,b2->pmin.z,b3->pmin.z), z1=_mm_setr_ps(b0->pmax.z,b1->pmax.z,b2->pmax.z,b3->pmax.z);
+		__m128 cx=_mm_mul_ps(_mm_add_ps(x0,x1),half), cy=_mm_mul_ps(_mm_add_ps(y0,y1),half), cz=_mm_mul_ps(_mm_add_ps(z0,z1),half);
+		__m128 ex=_mm_mul_ps(_mm_sub_ps(x1,x0),half), ey=_mm_mul_ps(_mm_sub_ps(y1,y0),half), ez=_mm_mul_ps(_mm_sub_ps(z1,z0),half);
+		__m128 in=_mm_cmpeq_ps(zero,zero);
+		for( int j=0; j<6; j++ )
+		{
+			__m128 dist=_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx,px[j]),_mm_mul_ps(cy,py[j])),_mm_add_ps(_mm_mul_ps(cz,pz[j]),pd[j]));
+			__m128 rad=_mm_add_ps(_mm_add_ps(_mm_mul_ps(ex,ax[j]),_mm_mul_ps(ey,ay[j])),_mm_mul_ps(ez,az[j]));
+			in=_mm_and_ps(in,_mm_cmpge_ps(_mm_add_ps(dist,rad),zero));
+		}
+		int mask=_mm_movemask_ps(in);
+		for( int i=0; i<4; i++ ) n+=(visible[k+i]=uchar((mask>>i)&1));
+	}
+#endif
+	for( ; k<count; k++ ) n+=(visible[k]=intersects(b[k])?1:0);
+	return n;
+}
+
+//*******************************************************************
+// analytic occlusion by a large sphere, seen from the origin (i.e., eye-relative coordinates)
+// - a sphere is hidden if it lies inside the cone the occluder subtends and entirely
+//   beyond the occluder's center; both conditions are conservative
+// - the cone test is the signed distance to the lateral surface: a*sin-rho*cos >= radius,
+//   where a and rho are the axial and radial components of the center
+struct sphere_occluder
+{
+	vec3	axis;				// unit direction to the occluder
+	float	distance = 0;		// to the occluder's center
+	float	sin_a = 0, cos_a = 1;	// half angle of the cone
+
+	sphere_occluder(){}
+	explicit sphere_occluder( const sphere3& s ){ set(s); }
+
+	inline sphere_occluder& set( const sphere3& s )
+	{
+		distance=s.center.length(); axis=distance>0?s.center/distance:vec3(0,0,1);
+		if(distance<=s.radius){ sin_a=0; cos_a=1; distance=FLT_MAX; return *this; } // the eye is inside: occludes nothing
+		sin_a=s.radius/distance; cos_a=sqrtf(1.0f-sin_a*sin_a);
+		return *this;
+	}
+
+	inline bool occludes( const sphere3& s ) const
+	{
+		float a=s.center.dot(axis), d2=s.center.length2();
+		if(a<=0||d2<(distance+s.radius)*(distance+s.radius)) return false;
+		return a*sin_a-sqrtf(max(d2-a*a,0.0f))*cos_a>=s.radius;
+	}
+};
+
 #endif // __CGMATH_H__
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef __ECS_H__
+#define __ECS_H__
+
+#include "cgmath.h"		// slee's simple math library
+
+//*************************************
+// minimal entity-component store
+// - an entity is only an id; each component type lives in its own packed array
+// - systems iterate the packed arrays linearly; owner[i] gives the entity of data[i],
+//   and the sparse index maps an entity back to its component for lookups
+// - removal swaps the last component into the hole, so the arrays stay packed
+typedef uint entity;
+static const uint ECS_NONE = ~0u;
+
+template <class T> struct component_array
+{
+	std::vector<T>		data;	// packed components
+	std::vector<entity>	owner;	// entity of data[i]
+	std::vector<uint>	index;	// position in data of an entity, or ECS_NONE
+
+	size_t size() const { return data.size(); }
+	bool has( entity e ) const { return e<index.size()&&index[e]!=ECS_NONE; }
+
+	T& add( entity e, const T& c=T() )
+	{
+		if(has(e)) return data[index[e]]=c;
+		if(e>=index.size()) index.resize(size_t(e)+1,ECS_NONE);
+		index[e] = uint(data.size()); data.push_back(c); owner.push_back(e);
+		return data.back();
+	}
+
+	void remove( entity e )
+	{
+		if(!has(e)) return;
+		uint i = index[e], last = uint(data.size()-1);
+		data[i] = data[last]; owner[i] = owner[last]; index[owner[i]] = i;
+		data.pop_back(); owner.pop_back(); index[e] = ECS_NONE;
+	}
+
+	T& operator[]( entity e ){ return data[index[e]]; }
+	const T& operator[]( entity e ) const { return data[index[e]]; }
+	T* find( entity e ){ return has(e) ? &data[index[e]] : nullptr; }
+	const T* find( entity e ) const { return has(e) ? &data[index[e]] : nullptr; }
+};
+
+#endif // __ECS_H__
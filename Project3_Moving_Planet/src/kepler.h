@@ -0,0 +1,102 @@
+#pragma once
+#ifndef __KEPLER_H__
+#define __KEPLER_H__
+
+#include "cgmath.h"		// slee's simple math library
+
+//*************************************
+// Keplerian orbits: ellipses with a focus at the parent, inclined to the xz plane
+// - elements: semi-major axis a, eccentricity e, inclination i, longitude of the ascending
+//   node, argument of periapsis, mean motion n, and mean anomaly M0 at t=0
+// - Kepler's equation M = E-e*sin(E) is solved for the eccentric anomaly E by Newton's
+//   method with a fixed number of steps, so a batch of bodies runs as one vectorized loop
+// - the orientation is folded into two unit vectors P and Q of the orbital plane, so a
+//   position costs one sincos after the solve: a*(cos(E)-e)*P + a*sqrt(1-e^2)*sin(E)*Q
+// - the solve runs in float, but a, P, Q, and the position are double, so a body far from
+//   the origin keeps its precision until the camera-relative subtraction (see scene.h)
+// - with all angles zero, the orbit starts at +z and moves toward +x about the +y axis
+static const int KEPLER_ITERATIONS = 5;	// converges to float precision for e <= 0.9 (see bench_kepler)
+
+// Newton steps from Danby's starting guess E0 = M+0.85*e*sign(M); M in [-pi,pi]
+inline float kepler_solve( float M, float e )
+{
+	float E = M+copysignf(0.85f*e,M);
+	for( int k=0; k < KEPLER_ITERATIONS; k++ )
+	{
+		float s, c; fast_sincos( E, s, c );
+		E -= (E-e*s-M)/(1.0f-e*c);
+	}
+	return E;
+}
+
+// the same solve over arrays of mean anomalies and eccentricities
+inline void kepler_solve( const float* M, const float* e, float* E, size_t n )
+{
+	#pragma omp simd
+	for( ptrdiff_t k=0; k < ptrdiff_t(n); k++ ) E[k] = kepler_solve( M[k], e[k] );
+}
+
+struct kepler_orbit
+{
+	double	a = 0;					// semi-major axis
+	float	e = 0;					// eccentricity in [0,1)
+	float	n = 0;					// mean motion in radians per second
+	float	M0 = 0;					// mean anomaly at t=0
+	dvec3	P = dvec3(0,0,1);		// unit vector toward the periapsis
+	dvec3	Q = dvec3(1,0,0);		// unit vector 90 degrees ahead along the motion
+
+	kepler_orbit() = default;
+	kepler_orbit( double a, float e, float n, double inclination=0, double node=0, double periapsis=0, float M0=0 ) : a(a), e(e), n(n), M0(M0)
+	{
+		// P and Q of the classic z-up formulation, with its (x,y,z) mapped to our (z,x,y)
+		double cn=cos(node), sn=sin(node), ci=cos(inclination), si=sin(inclination), cw=cos(periapsis), sw=sin(periapsis);
+		P = dvec3( sn*cw+cn*sw*ci, sw*si, cn*cw-sn*sw*ci );
+		Q = dvec3( -sn*sw+cn*cw*ci, cw*si, -cn*sw-sn*cw*ci );
+	}
+
+	double period() const { return n==0 ? 0 : 2.0*PI_D/fabs(double(n)); }
+
+	// mean anomaly at time t, reduced to [-pi,pi] in double to keep float precision over time
+	float mean_anomaly( double t ) const { double M=double(M0)+double(n)*t; return float(M-2.0*PI_D*floor(M*(0.5/PI_D)+0.5)); }
+
+	// position relative to the parent from the eccentric anomaly, in double
+	dvec3 position_at( float E ) const
+	{
+		double s=sin(double(E)), c=cos(double(E)), ed=e;
+		return P*(a*(c-ed))+Q*(a*sqrt(1.0-ed*ed)*s);
+	}
+
+	dvec3 position( double t ) const { return position_at( kepler_solve( mean_anomaly(t), e ) ); }
+};
+
+//*************************************
+// ephemeris: positions sampled uniformly in time over one period, so a lookup is O(1)
+// without solving Kepler's equation; Catmull-Rom interpolation between the samples keeps
+// the velocity continuous, and its error falls with the cube of the sample spacing
+struct kepler_ephemeris
+{
+	std::vector<dvec3>	samples;	// p(-dt), p(0), ..., p(count*dt), p((count+1)*dt): padded to wrap around
+	double				period = 0;
+
+	size_t size() const { return samples.size()<3 ? 0 : samples.size()-3; }
+
+	void create( const kepler_orbit& o, uint count=256 )
+	{
+		samples.clear(); period = o.period(); if(period==0||count==0) return;
+		double dt = period/count;
+		samples.resize(size_t(count)+3);
+		for( uint k=0; k < count+3; k++ ) samples[k] = o.position( (double(k)-1.0)*dt );
+	}
+
+	dvec3 position( double t ) const
+	{
+		if(samples.empty()) return dvec3(0);
+		double u = t/period; u = (u-floor(u))*double(size());
+		size_t i = min(size_t(u),size()-1); double f = u-double(i);
+		const dvec3 *p = &samples[i];		// p[1] and p[2] bracket the time
+		double f2=f*f, f3=f2*f;
+		return (p[0]*(-f3+2.0*f2-f)+p[1]*(3.0*f3-5.0*f2+2.0)+p[2]*(-3.0*f3+4.0*f2+f)+p[3]*(f3-f2))*0.5;
+	}
+};
+
+#endif // __KEPLER_H__
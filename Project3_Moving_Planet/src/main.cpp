@@ -1,6 +1,13 @@
+#include <condition_variable>	// include before cgmath.h, which defines min/max macros
+#include <functional>
+#include <thread>
 #include "cgmath.h"		// slee's simple math library
 #include "cgut.h"		// slee's OpenGL utility
-#include "planet.h"		// planet class definition
+#include "sphere.h"		// sphere tessellation
+#include "meshopt.h"	// vertex cache/fetch optimization
+#include "meshcache.h"	// mesh cache on disk
+#include "planet.h"		// celestial body components and systems
+#include "simclock.h"	// simulation clock
 #include "trackball.h"
 
 //*************************************
@@ -8,37 +15,136 @@
 static const char*	window_name = "Project 3 - Moving Planets";
 static const char*	vert_shader_path = "../bin/shaders/project3.vert";
 static const char*	frag_shader_path = "../bin/shaders/project3.frag";
-uint				NUM_TESS = 72;		// initial tessellation factor of the circle as a polygon
+static const char*	mesh_cache_dir = "../bin/cache";
+static const std::vector<uint> LOD_SEGMENTS = { 8, 16, 32, 64, 128, 256 };	// tessellation factors of the sphere LOD chain
+float				LOD_PIXEL_ERROR = 0.5f;	// tolerated silhouette error in pixels
+float				OCCLUDER_MIN_RADIUS = 5.0f;	// bodies this large hide what is behind them
+static const uint	EPHEMERIS_SAMPLES = 256;	// samples per revolution of the precomputed orbits
+static const float	NBODY_DT = 1.0f / 60.0f;	// simulation seconds of an n-body step
+static const uint	NBODY_MAX_STEPS = 4;		// most n-body steps per frame at large time scales
 
 //*************************************
 // common structures
 
+// per-instance attributes streamed every frame: the eye-relative model matrix and the color
+struct instance
+{
+	vec4	row[3];		// rows of the affine model matrix (mat4x3 layout)
+	vec4	color;
+
+	static const uint location = 3;	// layout(location=3) of the first instance attribute
+	static vertex_format format(){ return { sizeof(instance), { {4,GL_FLOAT,GL_FALSE,offsetof(instance,row)}, {4,GL_FLOAT,GL_FALSE,offsetof(instance,row)+sizeof(vec4)}, {4,GL_FLOAT,GL_FALSE,offsetof(instance,row)+sizeof(vec4)*2}, {4,GL_FLOAT,GL_FALSE,offsetof(instance,color)} } }; }
+};
+
+// particles drawn as unrotated spheres: belts, rings, and the n-body disk share the culling and
+// instancing paths through their x/y/z, scale, and shade arrays around an eye-relative center
+struct particle_source
+{
+	vec3			center;
+	const float		*x, *y, *z, *scale, *shade;
+	size_t			count;
+	vec3			rgb;
+
+	template <class T> static particle_source of( const T& p, const vec3& center ){ return { center, p.x.data(), p.y.data(), p.z.data(), p.scale.data(), p.shade.data(), p.size(), p.desc.rgb }; }
+};
+
+// per-frame uniforms: the std140 layout of frame_block in the shaders, with row-major matrices
+struct frame_uniforms
+{
+	mat4	view_matrix;			// without the eye translation
+	mat4	projection_matrix;
+	mat4	view_projection_matrix;
+	vec4	viewport;				// x, y, width, and height in pixels
+	float	time;					// simulation seconds
+	int		b_solid_color;
+	int		b_procedural;
+	int		pad;
+
+	static const GLuint binding = 0;	// uniform buffer binding point of frame_block
+};
+
+// per-draw uniforms: the std140 layout of draw_block; each draw binds its own range of the buffer
+struct draw_uniforms
+{
+	int		tess;					// tessellation factor of the procedural sphere
+	int		pad[3];
+
+	static const GLuint binding = 1;	// uniform buffer binding point of draw_block
+};
+static_assert(sizeof(frame_uniforms)==224&&sizeof(draw_uniforms)==16, "uniform structures should match the std140 blocks");
 
 //*************************************
 // window objects
 GLFWwindow*	window = nullptr;
 ivec2		window_size = ivec2(1280, 720); // initial window size
 GLuint		vertex_array = 0;	// ID holder for vertex array object
+GLuint		empty_vertex_array = 0;	// no attributes: the procedural sphere is computed from gl_VertexID
+GLenum		index_type = GL_UNSIGNED_INT;	// GL_UNSIGNED_SHORT for meshes of up to 65536 vertices
 
 //*************************************
 // OpenGL objects
 GLuint	program	= 0;	// ID holder for GPU program
+GLuint	instance_buffer = 0;	// ID holder for the per-instance attributes
+GLuint	uniform_buffer = 0;		// ID holder for the per-frame uniforms followed by the per-draw uniforms
 
 //*************************************
 // global variables
 int		frame = 0;		// index of rendering frames
+sim_clock	sim;		// simulation clock
+frame_uniforms	uniforms;	// filled in update(), and uploaded with the per-draw uniforms in render()
 int		visualization = 0; //for text coordination visualization
 
 bool	b_solid_color = false;
 bool	b_wireframe = false;
-auto	planets = std::move(create_planets());
+bool	b_lod = true;		// select sphere levels by screen-space size
+bool	b_frustum_culling = true;
+bool	b_occlusion_culling = true;	// by bodies of at least OCCLUDER_MIN_RADIUS
+bool	b_procedural = false;	// generate spheres in the vertex shader without vertex/index buffers
+bool	b_belts = true;		// draw belts and rings
+bool	b_ephemeris = false;	// look up the orbits in precomputed tables instead of solving Kepler's equation
+bool	b_nbody = false;	// simulate and draw the self-gravitating disk
+uint	nbody_count = 0;	// bodies of the disk; 0 keeps the count of solar_disk
+uint	belt_count = 0;		// bodies of the main belt; 0 keeps the count of solar_belts[]
+
+struct
+{
+	size_t	tested = 0;		// bodies and belt particles
+	size_t	visible = 0;	// in the view frustum
+	size_t	unoccluded = 0;	// in the view frustum and not hidden by an occluder
+	size_t	drawn = 0;		// instances
+	size_t	draw_calls = 0;
+	size_t	triangles = 0;
+} stats; // of the last frame
 
 
 //*************************************
 // scene objects
-std::vector<vertex> unit_sphere_vertices;
+std::vector<sphere_lod> sphere_lods;
+scene_graph	scene;		// orbit nodes carry the revolution, and body nodes the rotation and the radius
+celestial_world	bodies;
+std::vector<entity>			body_entities;	// entities of solar_system[]
+std::vector<particle_belt>	belts;
+std::vector<int>			belt_nodes;		// scene node of the center of each belt, or -1 for the origin
+nbody_system	nbody;			// created when first enabled
+work_pool		pool;			// threads of the n-body steps
+std::vector<instance>	instances;		// bucketed by sphere level
+std::vector<uint>		instance_levels;	// sphere level per body and belt particle, or ECS_NONE when culled
+std::vector<sphere3>	bounds;				// eye-relative bounding spheres in the same order
+std::vector<uchar>		visible;
 trackball	tb;
 
+//*************************************
+// the coarsest level whose silhouette error stays within LOD_PIXEL_ERROR
+// - the projected radius in pixels uses the vertical focal length of cam.projection_matrix
+// - distance is measured from the eye, so camera-relative positions can be used directly
+const sphere_lod& select_lod( float radius, float distance )
+{
+	if(!b_lod||distance<=radius) return sphere_lods.back();
+	float radius_in_pixels = radius*cam.projection_matrix._22/distance*window_size.y*0.5f;
+	for( auto& l : sphere_lods ) if(l.error*radius_in_pixels<=LOD_PIXEL_ERROR) return l;
+	return sphere_lods.back();
+}
+
 //*************************************
 void update()
 {
@@ -46,11 +152,23 @@ void update()
 	cam.aspect_ratio = window_size.x / float(window_size.y);
 	cam.projection_matrix = mat4::perspective(cam.fovy, cam.aspect_ratio, cam.dNear, cam.dFar);
 
-	// update uniform variables in vertex/fragment shaders
-	GLint uloc;
-	uloc = glGetUniformLocation(program, "b_solid_color");		if (uloc > -1) glUniform1i(uloc, b_solid_color);
-	uloc = glGetUniformLocation(program, "view_matrix");		if (uloc > -1) glUniformMatrix4fv(uloc, 1, GL_TRUE, cam.view_matrix);		// update the view matrix
-	uloc = glGetUniformLocation(program, "projection_matrix");	if (uloc > -1) glUniformMatrix4fv(uloc, 1, GL_TRUE, cam.projection_matrix);	// update the projection matrix
+	// animate the local transforms, and propagate them to the world transforms
+	sim.tick(glfwGetTime());
+	double t = sim.time;
+	orbit_system(bodies, scene, t, b_ephemeris);
+	spin_system(bodies, scene, t);
+	scene.update();
+	if (b_belts) for (auto& b : belts) b.evaluate(t);
+	if (b_nbody) for (uint k = sim.steps(NBODY_DT, NBODY_MAX_STEPS); k; k--) nbody.step(pool, NBODY_DT);	// fixed steps keep the run deterministic
+
+	// update the per-frame uniforms of the shaders
+	uniforms.view_matrix = rte_view_matrix(cam.view_matrix);	// the view matrix without the eye translation
+	uniforms.projection_matrix = cam.projection_matrix;
+	uniforms.view_projection_matrix = cam.projection_matrix * uniforms.view_matrix;
+	uniforms.viewport = vec4(0, 0, float(window_size.x), float(window_size.y));
+	uniforms.time = float(t);
+	uniforms.b_solid_color = b_solid_color;
+	uniforms.b_procedural = b_procedural;
 }
 
 void render()
@@ -61,24 +179,94 @@ void render()
 	// notify GL that we use our own program
 	glUseProgram( program );
 	
-	// bind vertex array object
-	glBindVertexArray(vertex_array);
-	float t = float(glfwGetTime());
-	for (auto& p: planets)
+	const dvec3& eye = cam.eye;	// camera-relative rendering: subtract the eye in double
+	transform_system(bodies, scene, eye);
+
+	// eye-relative bounding spheres of the bodies and the particles
+	std::vector<particle_source> particles;
+	for (size_t b = 0; b_belts && b < belts.size(); b++) particles.push_back(particle_source::of(belts[b], vec3((belt_nodes[b] < 0 ? dvec3(0.0) : scene.world_position[belt_nodes[b]]) - eye)));
+	if (b_nbody) particles.push_back(particle_source::of(nbody, vec3(-eye)));	// the disk is simulated around the world origin
+	size_t count = bodies.meshes.size();
+	for (auto& p : particles) count += p.count;
+	bounds.resize(count); visible.resize(count);
+	size_t k = 0;
+	for (size_t j = 0; j < bodies.meshes.size(); j++, k++)
+	{
+		const transform_component* x = bodies.transforms.find(bodies.meshes.owner[j]);
+		bounds[k] = sphere3(x ? x->model_matrix.translation() : vec3(0), bodies.meshes.data[j].radius);
+	}
+	for (auto& p : particles) for (size_t j = 0; j < p.count; j++, k++) bounds[k] = sphere3(p.center + vec3(p.x[j], p.y[j], p.z[j]), p.scale[j]);
+
+	// frustum culling: the view without the eye translation matches the eye-relative bounds
+	stats.tested = count;
+	if (b_frustum_culling) stats.visible = frustum(uniforms.view_projection_matrix).cull(bounds.data(), count, visible.data());
+	else { std::fill(visible.begin(), visible.end(), uchar(1)); stats.visible = count; }
+	for (size_t j = 0; j < bodies.meshes.size(); j++) if (visible[j] && !bodies.transforms.has(bodies.meshes.owner[j])) { visible[j] = 0; stats.visible--; }	// nothing to draw
+
+	// occlusion culling by the large bodies in view
+	std::vector<sphere_occluder> occluders;
+	if (b_occlusion_culling) for (size_t j = 0; j < bodies.meshes.size(); j++) if (visible[j] && bounds[j].radius >= OCCLUDER_MIN_RADIUS) occluders.emplace_back(bounds[j]);
+	stats.unoccluded = stats.visible;
+	if (!occluders.empty()) for (k = 0; k < count; k++)
+		if (visible[k]) for (auto& o : occluders) if (o.occludes(bounds[k])) { visible[k] = 0; stats.unoccluded--; break; }
+
+	// select the level of each visible instance, and bucket the instances by level with a counting sort
+	size_t levels = sphere_lods.size();
+	std::vector<size_t> first(levels + 1, 0);
+	instance_levels.resize(count);
+	for (k = 0; k < count; k++) instance_levels[k] = visible[k] ? uint(&select_lod(bounds[k].radius, length(bounds[k].center)) - sphere_lods.data()) : ECS_NONE;
+	for (uint level : instance_levels) if (level != ECS_NONE) first[level + 1]++;
+	for (size_t l = 0; l < levels; l++) first[l + 1] += first[l];
+	instances.resize(first[levels]);
+	std::vector<size_t> next(first.begin(), first.end() - 1);
+	k = 0;
+	for (size_t j = 0; j < bodies.meshes.size(); j++, k++)
 	{
-		float pr = p.planetRadius;
-		float rr = p.revRadius;
-
-		mat4 model_matrix =	mat4::translate(rr * sin(t * p.revSpeed), 0, rr * cos(t * p.revSpeed)) *
-							mat4::translate(cam.at) *
-							mat4::rotate(vec3(0, 1, 0), t * p.rotSpeed) *
-							mat4::translate(-cam.at) *
-							mat4::scale(pr);
-
-		// update the uniform model matrix and render
-		glUniform4fv(glGetUniformLocation(program, "solid_color"), 1, p.rgb);	// pointer version
-		glUniformMatrix4fv(glGetUniformLocation(program, "model_matrix"), 1, GL_TRUE, model_matrix);
-		glDrawElements(GL_TRIANGLES, NUM_TESS * NUM_TESS * 3, GL_UNSIGNED_INT, nullptr);
+		if (instance_levels[k] == ECS_NONE) continue;
+		entity e = bodies.meshes.owner[j];
+		const color_component* c = bodies.colors.find(e);
+		instance& i = instances[next[instance_levels[k]]++];
+		for (int r = 0; r < 3; r++) i.row[r] = bodies.transforms[e].model_matrix.rvec4(r);
+		i.color = vec4(c ? c->rgb : vec3(1), 1.0f);
+	}
+	for (auto& p : particles) for (size_t j = 0; j < p.count; j++, k++)	// unrotated spheres scaled at the evaluated positions
+	{
+		if (instance_levels[k] == ECS_NONE) continue;
+		instance& i = instances[next[instance_levels[k]]++];
+		const sphere3& s = bounds[k];
+		i.row[0] = vec4(s.radius, 0, 0, s.center.x);
+		i.row[1] = vec4(0, s.radius, 0, s.center.y);
+		i.row[2] = vec4(0, 0, s.radius, s.center.z);
+		i.color = vec4(p.rgb * p.shade[j], 1.0f);
+	}
+
+	// stream the instances: orphaning the old storage lets the driver skip waiting for draws still reading it
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(instance) * instances.size(), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(instance) * instances.size(), instances.data());
+
+	// upload the per-frame and per-draw uniforms in one transfer: the frame block comes first, and
+	// then a block per level, each at the offset alignment required by glBindBufferRange()
+	size_t draw_offset = cg_uniform_buffer_align(sizeof(frame_uniforms)), draw_stride = cg_uniform_buffer_align(sizeof(draw_uniforms));
+	std::vector<uchar> uniform_data(draw_offset + draw_stride * levels, 0);
+	memcpy(uniform_data.data(), &uniforms, sizeof(uniforms));
+	for (size_t l = 0; l < levels; l++) { draw_uniforms d = { int(sphere_lods[l].segments) }; memcpy(&uniform_data[draw_offset + draw_stride * l], &d, sizeof(d)); }
+	glBindBuffer(GL_UNIFORM_BUFFER, uniform_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, uniform_data.size(), uniform_data.data(), GL_STREAM_DRAW);	// orphans the storage of the last frame
+	glBindBufferRange(GL_UNIFORM_BUFFER, frame_uniforms::binding, uniform_buffer, 0, sizeof(frame_uniforms));
+
+	// one instanced draw per level
+	GLuint vao = b_procedural ? empty_vertex_array : vertex_array;
+	stats.drawn = instances.size(); stats.draw_calls = 0; stats.triangles = 0;
+	for (size_t l = 0; l < levels; l++)
+	{
+		GLsizei n = GLsizei(first[l + 1] - first[l]); if (!n) continue;
+		const sphere_lod& lod = sphere_lods[l];
+		cg_bind_instance_attributes(vao, instance_buffer, instance::format(), instance::location, first[l]);
+		glBindBufferRange(GL_UNIFORM_BUFFER, draw_uniforms::binding, uniform_buffer, draw_offset + draw_stride * l, sizeof(draw_uniforms));
+		if (b_procedural) glDrawArraysInstanced(GL_TRIANGLES, 0, GLsizei(lod.index_count), n);	// the level is only a uniform range
+		else glDrawElementsInstanced(GL_TRIANGLES, GLsizei(lod.index_count), index_type, (GLvoid*)(lod.first_index * (index_type == GL_UNSIGNED_SHORT ? sizeof(ushort) : sizeof(uint))), n);
+		stats.draw_calls++; stats.triangles += lod.index_count / 3 * n;
 	}
 	// swap front and back buffers, and display to screen
 	glfwSwapBuffers( window );
@@ -99,25 +287,23 @@ void print_help()
 	printf( "- press F1 or 'h' to see help\n" );
 	printf( "- press 'w' to toggle wireframe\n" );
 	printf( "- press 'd' to toggle between solid color and texture coordinates\n" );
+	printf( "- press 'l' to toggle level-of-detail selection\n" );
+	printf( "- press 'p' to toggle procedural spheres without vertex buffers\n" );
+	printf( "- press 'b' to toggle belts and rings\n" );
+	printf( "- press 'e' to toggle precomputed ephemerides for the orbits\n" );
+	printf( "- press 'n' to toggle the n-body disk simulated with a Barnes-Hut tree\n" );
+	printf( "- press 'c' to toggle frustum culling\n" );
+	printf( "- press 'o' to toggle occlusion culling by the large bodies\n" );
+	printf( "- press 'i' to print the statistics of the last frame\n" );
+	printf( "- press SPACE to pause/resume the simulation\n" );
+	printf( "- press ',/.' to slow down/speed up the simulation by 10x (x%g to x%g, x%g while the n-body disk runs)\n", sim_clock::MIN_SCALE, sim_clock::MAX_SCALE, sim_clock::reachable_scale(NBODY_DT,NBODY_MAX_STEPS) );
+	printf( "- press '/' to advance the simulation by one frame while paused\n" );
+	printf( "- run with a number to set the bodies of the main belt, e.g., project3 1000000\n" );
+	printf( "- run with a second number to set the bodies of the n-body disk, e.g., project3 20000 100000\n" );
 	printf( "\n" );
 }
 
-std::vector<vertex> create_sphere_vertices(uint N)
-{
-	std::vector<vertex> v = { { vec3(0), vec3(0,0,-1.0f), vec2(0.5f) } };
-	for (uint i = 0; i <= N; i++)
-	{
-		for (uint j = 0; j <= N / 2; j++) 
-		{
-			float t = PI * 2.0f * j / float(N), tc = cos(t), ts = sin(t);
-			float p = PI * 2.0f * i / float(N), pc = cos(p), ps = sin(p);
-			v.push_back({ vec3(ts * ps, tc, ts * pc), vec3(ts * pc, ts * ps, tc), vec2(p / (2.0f * PI), 1.0f - (t / PI)) });
-		}
-	}
-	return v;
-}
-
-void update_vertex_buffer(const std::vector<vertex>& vertices, uint N)
+void update_vertex_buffer(const mesh_data& m)
 {
 	static GLuint vertex_buffer = 0;	// ID holder for vertex buffer
 	static GLuint index_buffer = 0;		// ID holder for index buffer
@@ -127,40 +313,24 @@ void update_vertex_buffer(const std::vector<vertex>& vertices, uint N)
 	if (index_buffer)	glDeleteBuffers(1, &index_buffer);	index_buffer = 0;
 
 	// check exceptions
-	if (vertices.empty()) { printf("[error] vertices is empty.\n"); return; }
-
-	// create buffers
-	std::vector<uint> indices;
-	for (uint i = 0; i < N; i++) 
-	{
-		for (uint j = 0; j < N / 2; j++)
-		{
-			//set the order for front-facing, not back-facing
-			indices.push_back(i * (N / 2 + 1) + j + 1);
-			indices.push_back(i * (N / 2 + 1) + j + 2);
-			indices.push_back((i + 1) * (N / 2 + 1) + j + 2);
-
-			indices.push_back(i * (N / 2 + 1) + j + 1);	
-			indices.push_back((i + 1) * (N / 2 + 1) + j + 2);
-			indices.push_back((i + 1) * (N / 2 + 1) + j + 1);
-		}
-	}
+	if (!m.vertex_bytes) { printf("[error] vertices is empty.\n"); return; }
+	if (m.vertex_stride != sizeof(compact_vertex)) { printf("[error] vertices are not compact_vertex.\n"); return; }
 
-	// generation of vertex buffer: use vertices as it is
+	// generation of vertex buffer: compact vertices (16 bytes instead of 32 bytes), as they are
 	glGenBuffers(1, &vertex_buffer);
 	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, m.vertex_bytes, m.vertices, GL_STATIC_DRAW);
 
-	// geneation of index buffer
+	// geneation of index buffer: 16-bit indices when every vertex is addressable
 	//GL_ELEMENT_ARRAY_BUFFER == INDEX_BUFFER
 	glGenBuffers(1, &index_buffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint) * indices.size(), &indices[0], GL_STATIC_DRAW);
-	
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m.index_bytes, m.indices, GL_STATIC_DRAW);
+	index_type = m.index_size == sizeof(ushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 
 	// generate vertex array object, which is mandatory for OpenGL 3.3 and higher
 	if (vertex_array) glDeleteVertexArrays(1, &vertex_array);
-	vertex_array = cg_create_vertex_array(vertex_buffer, index_buffer);
+	vertex_array = cg_create_vertex_array(vertex_buffer, index_buffer, compact_vertex::format());
 	if (!vertex_array) { printf("%s(): failed to create vertex aray\n", __func__); return; }
 }
 
@@ -183,6 +353,63 @@ void keyboard( GLFWwindow* window, int key, int scancode, int action, int mods )
 			printf("> using %s mode\n", b_wireframe ? "wireframe" : "solid");
 		}
 #endif
+		else if (key == GLFW_KEY_L)
+		{
+			b_lod = !b_lod;
+			printf("> level of detail %s (%zu triangles in the last frame)\n", b_lod ? "on" : "off", stats.triangles);
+		}
+		else if (key == GLFW_KEY_P)
+		{
+			b_procedural = !b_procedural;
+			printf("> using %s spheres\n", b_procedural ? "procedural" : "buffered");
+		}
+		else if (key == GLFW_KEY_B)
+		{
+			b_belts = !b_belts;
+			size_t n = 0; for (auto& b : belts) n += b.size();
+			printf("> belts and rings %s (%zu bodies)\n", b_belts ? "on" : "off", n);
+		}
+		else if (key == GLFW_KEY_E)
+		{
+			b_ephemeris = !b_ephemeris;
+			printf("> orbits %s\n", b_ephemeris ? "from ephemerides" : "by solving Kepler's equation");
+		}
+		else if (key == GLFW_KEY_N)
+		{
+			b_nbody = !b_nbody;
+			if (b_nbody && !nbody.size()) { nbody_desc d = solar_disk; if (nbody_count) d.count = nbody_count; nbody.create(d); }
+			sim.limit_scale(b_nbody ? sim_clock::reachable_scale(NBODY_DT, NBODY_MAX_STEPS) : sim_clock::MAX_SCALE);	// the disk advances only in steps
+			printf("> n-body disk %s (%zu bodies, %u threads), time scale x%g (at most x%g)\n", b_nbody ? "on" : "off", nbody.size(), pool.size(), sim.scale, sim.max_scale);
+		}
+		else if (key == GLFW_KEY_C)
+		{
+			b_frustum_culling = !b_frustum_culling;
+			printf("> frustum culling %s\n", b_frustum_culling ? "on" : "off");
+		}
+		else if (key == GLFW_KEY_O)
+		{
+			b_occlusion_culling = !b_occlusion_culling;
+			printf("> occlusion culling %s\n", b_occlusion_culling ? "on" : "off");
+		}
+		else if (key == GLFW_KEY_SPACE)
+		{
+			sim.pause(!sim.paused);
+			printf("> simulation %s at %.2f s (%.2f s of the n-body disk dropped beyond %u steps per frame)\n", sim.paused ? "paused" : "resumed", sim.time, sim.dropped, NBODY_MAX_STEPS);
+		}
+		else if (key == GLFW_KEY_COMMA || key == GLFW_KEY_PERIOD)
+		{
+			sim.set_scale(key == GLFW_KEY_PERIOD ? sim.scale * 10 : sim.scale / 10);
+			printf("> time scale x%g (at most x%g)\n", sim.scale, sim.max_scale);
+		}
+		else if (key == GLFW_KEY_SLASH)
+		{
+			sim.step_once();
+		}
+		else if (key == GLFW_KEY_I)
+		{
+			printf("> %zu tested, %zu in the frustum, %zu unoccluded, %zu drawn in %zu calls, %zu triangles\n",
+				stats.tested, stats.visible, stats.unoccluded, stats.drawn, stats.draw_calls, stats.triangles);
+		}
 	}
 }
 
@@ -193,7 +420,7 @@ void mouse(GLFWwindow* window, int button, int action, int mods)
 	tb.button = button;
 	tb.mods = mods;
 
-	if (action == GLFW_PRESS) tb.begin(cam.view_matrix, npos);//start view change
+	if (action == GLFW_PRESS) tb.begin(cam.view_matrix, cam.eye, npos);//start view change
 	else if (action == GLFW_RELEASE) tb.end();//stop view change
 }
 
@@ -202,11 +429,11 @@ void motion(GLFWwindow* window, double x, double y)
 	if (!tb.is_tracking()) return;
 	vec2 npos = cursor_to_ndc(dvec2(x, y), window_size);//Ŀ ġ ȭ ǥ ű
 	if(tb.button==GLFW_MOUSE_BUTTON_LEFT&&tb.mods==0)
-		cam.view_matrix = tb.update(npos);
+		cam.view_matrix = tb.update(npos, cam.eye);
 	else if(tb.button == GLFW_MOUSE_BUTTON_MIDDLE || (tb.button==GLFW_MOUSE_BUTTON_LEFT&&(tb.mods & GLFW_MOD_CONTROL)))
-		cam.view_matrix = tb.update_pan(npos);
+		cam.view_matrix = tb.update_pan(npos, cam.eye);
 	else if (tb.button == GLFW_MOUSE_BUTTON_RIGHT || (tb.button == GLFW_MOUSE_BUTTON_LEFT && (tb.mods & GLFW_MOD_SHIFT))) {
-		cam.view_matrix = tb.update_zoom(npos);
+		cam.view_matrix = tb.update_zoom(npos, cam.eye);
 	}
 }
 
@@ -220,9 +447,60 @@ bool user_init()
 	glEnable( GL_CULL_FACE );								// turn on backface culling
 	glEnable( GL_DEPTH_TEST );								// turn on depth tests
 
-	unit_sphere_vertices = create_sphere_vertices(NUM_TESS);
+	// spawn the solar system into the entity-component store and the scene graph
+	body_entities = create_bodies(bodies, scene, solar_system, std::extent<decltype(solar_system)>::value, EPHEMERIS_SAMPLES);
+
+	// belts and rings follow the revolution of their parent body; the first one is the main belt
+	for (size_t k = 0; k < std::extent<decltype(solar_belts)>::value; k++)
+	{
+		belt_desc d = solar_belts[k]; if (k == 0 && belt_count) d.count = belt_count;
+		belts.emplace_back(); belts.back().create(d, uint(k));
+		belt_nodes.push_back(d.parent < 0 ? -1 : bodies.orbits[body_entities[d.parent]].node);
+	}
 
-	update_vertex_buffer(unit_sphere_vertices, NUM_TESS);
+	// the sphere LOD chain: every parameter of the generator goes into the cache description,
+	// and the version is to be bumped when the generator itself changes
+	std::string desc = "project3 sphere lod chain v1: uv y_up, forsyth 32 + fetch, compact_vertex, segments";
+	for (uint N : LOD_SEGMENTS) desc += " " + std::to_string(N);
+	std::string cache_path = mesh_cache_path(mesh_cache_dir, desc);
+
+	// a hit uploads directly from the mapped file; the draw ranges are in the aux blob
+	mesh_cache_file cache;
+	if (cache.open(cache_path, desc))
+	{
+		const mesh_data& m = cache.data();
+		sphere_lods.assign((const sphere_lod*)m.aux, (const sphere_lod*)m.aux + m.aux_bytes / sizeof(sphere_lod));
+		update_vertex_buffer(m);
+	}
+	else
+	{
+		// all the levels share a single vertex/index buffer
+		std::vector<vertex> vertices; std::vector<uint> indices;
+		sphere_lods = create_sphere_lod_chain(LOD_SEGMENTS, vertices, indices, true);	// poles on the y axis
+
+		// reorder triangles of each level for the post-transform cache, and then vertices for the fetch;
+		// levels reference disjoint vertex ranges, so the first-use order keeps each level contiguous
+		for (auto& l : sphere_lods) optimize_vertex_cache(&indices[l.first_index], l.index_count, vertices.size());
+		optimize_vertex_fetch(vertices, indices);
+
+		// GPU-ready blobs: compact vertices, and 16-bit indices when every vertex is addressable
+		std::vector<compact_vertex> compact_vertices(vertices.begin(), vertices.end());
+		std::vector<ushort> indices16; if (vertices.size() <= 65536) indices16.assign(indices.begin(), indices.end());
+
+		mesh_data m;
+		m.vertices = compact_vertices.data();	m.vertex_bytes = sizeof(compact_vertex) * compact_vertices.size();	m.vertex_stride = sizeof(compact_vertex);
+		if (!indices16.empty()) { m.indices = indices16.data(); m.index_bytes = sizeof(ushort) * indices16.size(); m.index_size = sizeof(ushort); }
+		else { m.indices = indices.data(); m.index_bytes = sizeof(uint) * indices.size(); m.index_size = sizeof(uint); }
+		m.aux = sphere_lods.data();	m.aux_bytes = sizeof(sphere_lod) * sphere_lods.size();
+
+		mesh_cache_store(cache_path, desc, m);
+		update_vertex_buffer(m);
+	}
+	glGenVertexArrays(1, &empty_vertex_array);	// core profiles need a bound vertex array even without attributes
+	glGenBuffers(1, &instance_buffer);			// filled in render()
+	glGenBuffers(1, &uniform_buffer);			// filled in render()
+	if (!cg_bind_uniform_block(program, "frame_block", frame_uniforms::binding)) return false;
+	if (!cg_bind_uniform_block(program, "draw_block", draw_uniforms::binding)) return false;
 	return true;
 }
 
@@ -232,6 +510,9 @@ void user_finalize()
 
 int main( int argc, char* argv[] )
 {
+	if (argc > 1) belt_count = uint(atoi(argv[1]));	// bodies of the main belt
+	if (argc > 2) nbody_count = uint(atoi(argv[2]));	// bodies of the n-body disk
+
 	// create window and initialize OpenGL extensions
 	if(!(window = cg_create_window( window_name, window_size.x, window_size.y ))){ glfwTerminate(); return 1; }
 	if(!cg_init_extensions( window )){ glfwTerminate(); return 1; }	// version and extensions
@@ -0,0 +1,291 @@
+#pragma once
+#ifndef __NBODY_H__
+#define __NBODY_H__
+
+#include "workpool.h"	// work-stealing threads; includes cgmath.h
+
+//*************************************
+// self-gravitating disk around a central mass, integrated by kick-drift-kick leapfrog
+// - the disk bodies live in structure-of-arrays; the central mass is kept apart, acts on
+//   every body exactly, and is pulled back by the sum of their reactions
+// - the Barnes-Hut octree is rebuilt every step: bodies are sorted by 30-bit Morton codes,
+//   so every node covers a contiguous range, and the nodes are laid out depth-first with
+//   a skip index (next), so a walk needs no stack
+// - forces are evaluated per group, the largest nodes of at most NBODY_GROUP_SIZE bodies:
+//   a group walks the tree once with its bounding box, and the resulting interaction list
+//   is applied to all its bodies in one vectorized loop
+// - a node is accepted when its diagonal is below theta times its distance to the group
+//   box; with theta<1 no body of an accepted node can come closer than its diagonal
+static const uint NBODY_LEAF_SIZE = 16;		// most bodies of a leaf
+static const uint NBODY_GROUP_SIZE = 128;	// most bodies sharing a walk
+
+struct nbody_desc
+{
+	uint		count;				// bodies of the disk
+	float		inner, outer;		// radii of the disk edges
+	float		thickness;			// vertical extent
+	float		central_mass;		// mass of the center, with G=1
+	float		disk_mass;			// total mass of the disk
+	float		softening;			// plummer softening length
+	float		theta;				// opening angle of the Barnes-Hut acceptance
+	float		min_size, max_size;	// radii of the drawn bodies
+	vec3		rgb;
+};
+
+struct nbody_system
+{
+	struct node
+	{
+		vec3	com;				// center of mass
+		float	mass;
+		vec3	lo, hi;				// tight bounding box of the bodies
+		float	diag2;				// squared diagonal of the box
+		uint	first, count;		// range of the sorted bodies
+		uint	next;				// index after the subtree
+		uint	leaf;
+	};
+
+	nbody_desc			desc;
+	std::vector<float>	x, y, z, vx, vy, vz, ax, ay, az, mass;	// disk bodies, in Morton order after each step
+	std::vector<float>	scale, shade;							// radius and brightness of the drawn bodies
+	vec3				center = vec3(0), center_velocity = vec3(0), center_acceleration = vec3(0);
+	std::vector<node>	nodes;
+	std::vector<uint>	groups;		// nodes walking the tree together
+	double				time = 0;
+
+	size_t size() const { return x.size(); }
+
+	void create( const nbody_desc& d, uint seed=0 )
+	{
+		desc = d; time = 0; center = center_velocity = center_acceleration = vec3(0);
+		size_t n = d.count;
+		for( auto* v : arrays() ) v->resize(n);
+
+		// bodies on circular orbits around the central mass and the disk inside them
+		uint s = seed*2654435761u+1u; auto rnd = [&](){ s = s*1664525u+1013904223u; return float(s>>8)/float(1<<24); };
+		float m = n ? d.disk_mass/float(n) : 0;
+		for( size_t k=0; k < n; k++ )
+		{
+			float r = sqrtf(d.inner*d.inner+(d.outer*d.outer-d.inner*d.inner)*rnd());	// uniform surface density
+			float a = rnd()*2.0f*PI, h = d.thickness*(rnd()+rnd()+rnd()-1.5f)/1.5f;
+			float enclosed = d.central_mass+d.disk_mass*(r*r-d.inner*d.inner)/(d.outer*d.outer-d.inner*d.inner);
+			float v = sqrtf(enclosed/r);
+			x[k] = r*sinf(a); y[k] = h; z[k] = r*cosf(a);
+			vx[k] = v*cosf(a); vy[k] = 0; vz[k] = -v*sinf(a);
+			mass[k] = m;
+			scale[k] = d.min_size+(d.max_size-d.min_size)*rnd()*rnd();
+			shade[k] = 0.6f+0.4f*rnd();
+		}
+		nodes.clear(); groups.clear();
+	}
+
+	// advances by dt with kick-drift-kick; forces at the end of a step are reused by the next one
+	void step( work_pool& pool, float dt )
+	{
+		if(nodes.empty()) compute_forces( pool );
+		kick( pool, dt*0.5f ); drift( pool, dt );
+		compute_forces( pool );
+		kick( pool, dt*0.5f );
+		time += dt;
+	}
+
+	// total energy with a direct O(n^2) sum, for checking the integrator
+	double energy() const
+	{
+		double e = 0.5*double(desc.central_mass)*double(center_velocity.length2()), eps2 = double(desc.softening)*desc.softening;
+		for( size_t i=0; i < size(); i++ )
+		{
+			double v2 = double(vx[i])*vx[i]+double(vy[i])*vy[i]+double(vz[i])*vz[i];
+			double dx = double(x[i])-center.x, dy = double(y[i])-center.y, dz = double(z[i])-center.z;
+			e += 0.5*mass[i]*v2-double(desc.central_mass)*mass[i]/sqrt(dx*dx+dy*dy+dz*dz+eps2);
+			for( size_t j=i+1; j < size(); j++ )
+			{
+				dx = double(x[j])-x[i]; dy = double(y[j])-y[i]; dz = double(z[j])-z[i];
+				e -= double(mass[i])*mass[j]/sqrt(dx*dx+dy*dy+dz*dz+eps2);
+			}
+		}
+		return e;
+	}
+
+	// rebuilds the tree and evaluates the accelerations of the disk and the center
+	void compute_forces( work_pool& pool )
+	{
+		build_tree( pool );
+		size_t n = size();
+		const float eps2 = desc.softening*desc.softening, theta2 = desc.theta*desc.theta, M = desc.central_mass;
+		pool.parallel_for( groups.size(), 4, [&]( size_t begin, size_t end )
+		{
+			thread_local std::vector<float> lx, ly, lz, lm;	// interaction list of a group
+			for( size_t l=begin; l < end; l++ )
+			{
+				const node& g = nodes[groups[l]];
+				lx.clear(); ly.clear(); lz.clear(); lm.clear();
+				for( uint i=0; i < nodes.size(); )
+				{
+					const node& c = nodes[i];
+					vec3 d = vec3( max(max(g.lo.x-c.com.x,c.com.x-g.hi.x),0.0f), max(max(g.lo.y-c.com.y,c.com.y-g.hi.y),0.0f), max(max(g.lo.z-c.com.z,c.com.z-g.hi.z),0.0f) );
+					if(c.diag2<theta2*d.length2()){ lx.push_back(c.com.x); ly.push_back(c.com.y); lz.push_back(c.com.z); lm.push_back(c.mass); i=c.next; }
+					else if(c.leaf){ lx.insert(lx.end(),&x[c.first],&x[c.first+c.count]); ly.insert(ly.end(),&y[c.first],&y[c.first+c.count]); lz.insert(lz.end(),&z[c.first],&z[c.first+c.count]); lm.insert(lm.end(),&mass[c.first],&mass[c.first+c.count]); i=c.next; }
+					else i++;
+				}
+				lx.push_back(center.x); ly.push_back(center.y); lz.push_back(center.z); lm.push_back(M);
+
+				const float *px=lx.data(), *py=ly.data(), *pz=lz.data(), *pm=lm.data(); int m = int(lx.size());
+				for( uint k=g.first; k < g.first+g.count; k++ ) accelerate( px, py, pz, pm, m, x[k], y[k], z[k], eps2, ax[k], ay[k], az[k] );
+			}
+		});
+
+		// the center is pulled back by the reaction to its pull on each body
+		dvec3 r(0.0);
+		for( size_t k=0; k < n; k++ )
+		{
+			float dx=x[k]-center.x, dy=y[k]-center.y, dz=z[k]-center.z;
+			float inv = 1.0f/sqrtf(dx*dx+dy*dy+dz*dz+eps2), s = mass[k]*inv*inv*inv;
+			r += dvec3(dx*s,dy*s,dz*s);
+		}
+		center_acceleration = vec3(r);
+	}
+
+protected:
+	std::vector<uint>	codes, order, sorted_codes, sorted_order;	// morton codes of the bodies and their sort
+	std::vector<float>	temp;
+
+	// sums the pulls of an interaction list on a body; the body itself adds zero
+	static void accelerate( const float* px, const float* py, const float* pz, const float* pm, int m, float bx, float by, float bz, float eps2, float& ax, float& ay, float& az )
+	{
+		float sx=0, sy=0, sz=0;
+		#pragma omp simd reduction(+:sx,sy,sz)
+		for( int j=0; j < m; j++ )
+		{
+			float dx=px[j]-bx, dy=py[j]-by, dz=pz[j]-bz;
+			float inv = 1.0f/sqrtf(dx*dx+dy*dy+dz*dz+eps2), s = pm[j]*inv*inv*inv;
+			sx+=dx*s; sy+=dy*s; sz+=dz*s;
+		}
+		ax=sx; ay=sy; az=sz;
+	}
+
+	std::vector<std::vector<float>*> arrays(){ return { &x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &mass, &scale, &shade }; }
+
+	void kick( work_pool& pool, float dt )
+	{
+		pool.parallel_for( size(), 4096, [&]( size_t begin, size_t end )
+		{
+			#pragma omp simd
+			for( size_t k=begin; k < end; k++ ){ vx[k]+=ax[k]*dt; vy[k]+=ay[k]*dt; vz[k]+=az[k]*dt; }
+		});
+		center_velocity += center_acceleration*dt;
+	}
+
+	void drift( work_pool& pool, float dt )
+	{
+		pool.parallel_for( size(), 4096, [&]( size_t begin, size_t end )
+		{
+			#pragma omp simd
+			for( size_t k=begin; k < end; k++ ){ x[k]+=vx[k]*dt; y[k]+=vy[k]*dt; z[k]+=vz[k]*dt; }
+		});
+		center += center_velocity*dt;
+	}
+
+	// sorts the bodies by Morton codes, and builds the nodes depth-first
+	void build_tree( work_pool& pool )
+	{
+		size_t n = size();
+		nodes.clear(); groups.clear();
+		if(n==0) return;
+
+		vec3 lo(FLT_MAX), hi(-FLT_MAX);
+		for( size_t k=0; k < n; k++ ){ lo=vec3(min(lo.x,x[k]),min(lo.y,y[k]),min(lo.z,z[k])); hi=vec3(max(hi.x,x[k]),max(hi.y,y[k]),max(hi.z,z[k])); }
+		float extent = max(max(hi.x-lo.x,hi.y-lo.y),hi.z-lo.z), q = 1023.0f/max(extent,1e-6f);
+
+		codes.resize(n); order.resize(n);
+		pool.parallel_for( n, 4096, [&]( size_t begin, size_t end )
+		{
+			for( size_t k=begin; k < end; k++ )
+			{
+				codes[k] = morton( uint((x[k]-lo.x)*q), uint((y[k]-lo.y)*q), uint((z[k]-lo.z)*q) );
+				order[k] = uint(k);
+			}
+		});
+		radix_sort();
+
+		// gather every array into the sorted order
+		temp.resize(n);
+		for( auto* v : arrays() )
+		{
+			pool.parallel_for( n, 4096, [&]( size_t begin, size_t end ){ for( size_t k=begin; k < end; k++ ) temp[k]=(*v)[order[k]]; } );
+			v->swap(temp);
+		}
+
+		build( 0, uint(n), 9, false );
+	}
+
+	// spreads 10 bits of each coordinate into every third bit
+	static uint morton( uint x, uint y, uint z )
+	{
+		auto spread = []( uint v ){ v=(v|(v<<16))&0x030000FF; v=(v|(v<<8))&0x0300F00F; v=(v|(v<<4))&0x030C30C3; return (v|(v<<2))&0x09249249; };
+		return spread(x)|(spread(y)<<1)|(spread(z)<<2);
+	}
+
+	// least-significant-digit radix sort of (codes, order) in three passes of 10 bits
+	void radix_sort()
+	{
+		size_t n = codes.size();
+		sorted_codes.resize(n); sorted_order.resize(n);
+		for( uint shift=0; shift < 30; shift+=10 )
+		{
+			uint count[1025] = {};
+			for( size_t k=0; k < n; k++ ) count[((codes[k]>>shift)&1023)+1]++;
+			for( uint b=0; b < 1024; b++ ) count[b+1] += count[b];
+			for( size_t k=0; k < n; k++ ){ uint d=count[(codes[k]>>shift)&1023]++; sorted_codes[d]=codes[k]; sorted_order[d]=order[k]; }
+			codes.swap(sorted_codes); order.swap(sorted_order);
+		}
+	}
+
+	// builds the subtree of the bodies [first,first+count) below the given octree level
+	uint build( uint first, uint count, int level, bool grouped )
+	{
+		// a level where every body falls into the same octant adds no node
+		while(level>=0&&octant(first,level)==octant(first+count-1,level)) level--;
+
+		uint k = uint(nodes.size()); nodes.emplace_back();
+		node c; c.first = first; c.count = count; c.leaf = count<=NBODY_LEAF_SIZE||level<0;
+		if(!grouped&&(count<=NBODY_GROUP_SIZE||c.leaf)){ groups.push_back(k); grouped = true; }
+		if(c.leaf)
+		{
+			double m=0, cx=0, cy=0, cz=0; c.lo=vec3(FLT_MAX); c.hi=vec3(-FLT_MAX);
+			for( uint i=first; i < first+count; i++ )
+			{
+				m+=mass[i]; cx+=double(mass[i])*x[i]; cy+=double(mass[i])*y[i]; cz+=double(mass[i])*z[i];
+				c.lo=vec3(min(c.lo.x,x[i]),min(c.lo.y,y[i]),min(c.lo.z,z[i])); c.hi=vec3(max(c.hi.x,x[i]),max(c.hi.y,y[i]),max(c.hi.z,z[i]));
+			}
+			c.mass = float(m); c.com = m>0 ? vec3(float(cx/m),float(cy/m),float(cz/m)) : (c.lo+c.hi)*0.5f;
+		}
+		else
+		{
+			uint children[8], child_count=0, end=first+count;
+			for( uint begin=first; begin < end; )
+			{
+				uint o = octant(begin,level), split = begin+1;
+				while(split<end&&octant(split,level)==o) split++;	// a linear scan costs O(n) per level, as the sort does
+				children[child_count++] = build( begin, split-begin, level-1, grouped );
+				begin = split;
+			}
+			double m=0, cx=0, cy=0, cz=0; c.lo=vec3(FLT_MAX); c.hi=vec3(-FLT_MAX);
+			for( uint i=0; i < child_count; i++ )
+			{
+				const node& h = nodes[children[i]];
+				m+=h.mass; cx+=double(h.mass)*h.com.x; cy+=double(h.mass)*h.com.y; cz+=double(h.mass)*h.com.z;
+				c.lo=vec3(min(c.lo.x,h.lo.x),min(c.lo.y,h.lo.y),min(c.lo.z,h.lo.z)); c.hi=vec3(max(c.hi.x,h.hi.x),max(c.hi.y,h.hi.y),max(c.hi.z,h.hi.z));
+			}
+			c.mass = float(m); c.com = m>0 ? vec3(float(cx/m),float(cy/m),float(cz/m)) : (c.lo+c.hi)*0.5f;
+		}
+		c.diag2 = (c.hi-c.lo).length2();
+		c.next = uint(nodes.size());
+		nodes[k] = c;
+		return k;
+	}
+
+	uint octant( uint i, int level ) const { return (codes[i]>>(3*level))&7; }
+};
+
+#endif // __NBODY_H__
@@ -2,45 +2,154 @@
 #ifndef __PLANET_H__
 #define __PLANET_H__
 
-struct planet_t
+#include "ecs.h"		// entity-component store
+#include "scene.h"		// scene graph
+#include "belt.h"		// belts and rings of small bodies
+#include "kepler.h"		// keplerian orbits and ephemerides
+#include "nbody.h"		// self-gravitating disk
+
+//*************************************
+// components of celestial bodies
+struct orbit_component
+{
+	kepler_orbit	orbit;				//revolution around the parent, or around the origin
+	int				node = -1;			//scene node of the revolution, which satellites are attached to
+};
+
+struct ephemeris_component
+{
+	kepler_ephemeris	table;			//precomputed revolution, which replaces the solve when enabled
+};
+
+struct spin_component
+{
+	float	speed = 1.0f;				//rotation speed
+	int		node = -1;					//scene node rotated
+};
+
+struct transform_component
+{
+	int		node = -1;					//scene node of the body
+	mat4x3	model_matrix;				//modeling transformation relative to the eye (affine)
+};
+
+struct mesh_component
+{
+	float	radius = 1.0f;				//radius of the sphere drawn from the LOD chain
+};
+
+struct color_component
+{
+	vec3	rgb = vec3(0);				//color of the body
+};
+
+struct celestial_world
 {
-	float	revRadius = 0.0f;			//revolution radius from sun
-	float	planetRadius = 1.0f;		//radius of planet
-	float	rotSpeed = 1.0f;			//rotation speed
-	float	revSpeed = 1.0f;			//revolution speed
-	vec3	rgb = vec3(0);				//color of planet 
-	mat4	model_matrix;				//modeling transformation
+	entity								count = 0;
+	component_array<orbit_component>	orbits;
+	component_array<ephemeris_component> ephemerides;
+	component_array<spin_component>		spins;
+	component_array<transform_component> transforms;
+	component_array<mesh_component>		meshes;
+	component_array<color_component>	colors;
+
+	entity create(){ return count++; }
 };
 
+//*************************************
+// bodies of the solar system; parent is the index of the body to revolve around
+// - revRadius is the semi-major axis and revSpeed the mean motion; the eccentricity and the
+//   angles in degrees (inclination, ascending node, argument of periapsis) are the real ones
+struct body_desc
+{
+	const char*	name;
+	float		revRadius, planetRadius, rotSpeed, revSpeed;
+	vec3		rgb;
+	int			parent;
+	float		eccentricity, inclination, node, periapsis;
+};
 
-planet_t sun = { 0, 15, 1, 0, {1, 1, 0} };
-planet_t mercury = { 20, 1, 0.5, 0.5, {211.0f / 255.0f, 211.0f / 255.0f, 211.0f / 255.0f} };
-planet_t venus = { 25, 2, 2, 1, {1, 215.0f/255.0f, 0} };
-planet_t earth = { 29, 2, 3, 1.5, {0, 1, 0} };
-planet_t mars = { 35, 1.5f, 4, 2.5, {1, 0, 0} };
-planet_t jupiter = { 50, 8, 6, 3, {1, 2.0f / 3.0f, 0} };
-planet_t saturn = { 70, 9, 4, 4.5, {165.0f / 255.0f, 42.0f / 255.0f, 42.0f / 255.0f} };
-planet_t uranus = {80, 3, 3, 3.5, {13.0f / 255.0f, 152.0f / 255.0f, 186.0f / 255.0f} };
-planet_t neptune = { 90, 3, 2, 4, {0,0,1} };
+static const body_desc solar_system[] =
+{
+	{ "sun",		0,	15,		1,		0,		{1, 1, 0},											-1,	0,			0,		0,		0 },
+	{ "mercury",	20,	1,		0.5f,	0.5f,	{211.0f / 255.0f, 211.0f / 255.0f, 211.0f / 255.0f},	-1,	0.2056f,	7,		48.3f,	29.1f },
+	{ "venus",		25,	2,		2,		1,		{1, 215.0f / 255.0f, 0},							-1,	0.0068f,	3.39f,	76.7f,	54.9f },
+	{ "earth",		29,	2,		3,		1.5f,	{0, 1, 0},											-1,	0.0167f,	0,		0,		102.9f },
+	{ "mars",		35,	1.5f,	4,		2.5f,	{1, 0, 0},											-1,	0.0934f,	1.85f,	49.6f,	286.5f },
+	{ "jupiter",	50,	8,		6,		3,		{1, 2.0f / 3.0f, 0},								-1,	0.0489f,	1.3f,	100.5f,	273.9f },
+	{ "saturn",		70,	9,		4,		4.5f,	{165.0f / 255.0f, 42.0f / 255.0f, 42.0f / 255.0f},	-1,	0.0565f,	2.49f,	113.7f,	339.4f },
+	{ "uranus",		80,	3,		3,		3.5f,	{13.0f / 255.0f, 152.0f / 255.0f, 186.0f / 255.0f},	-1,	0.0457f,	0.77f,	74,		96.9f },
+	{ "neptune",	90,	3,		2,		4,		{0, 0, 1},											-1,	0.0113f,	1.77f,	131.8f,	273.2f },
+	{ "moon",		4,	0.5f,	1,		6,		{0.75f, 0.75f, 0.75f},								3,	0.0549f,	5.14f,	125.1f,	318.1f },
+};
 
+// belts and rings; parent is the index of the body to surround, whose revolution they follow
+// - the main belt fills the gap between mars and jupiter; its count can be overridden at startup
+static const belt_desc solar_belts[] =
+{
+	{ "main belt",		-1,	20000,	39,		46,		0.8f,	0.03f,	0.25f,	1.2f,	{0.55f, 0.5f, 0.45f},	0 },
+	{ "saturn rings",	6,	30000,	11.5f,	17,		0.05f,	0.02f,	0.08f,	2.0f,	{0.85f, 0.78f, 0.6f},	0.47f },
+};
 
-inline std::vector<planet_t> create_planets()
+// n-body disk around the sun; the central mass gives the main belt's angular speed at its
+// radii, and the disk adds a tenth of it; its count can be overridden at startup
+static const nbody_desc solar_disk = { 20000, 20, 120, 2, 1e5f, 1e4f, 0.5f, 0.7f, 0.03f, 0.2f, {0.7f, 0.75f, 0.9f} };
+
+// spawns the bodies with all their components; a parent should precede its satellites
+// - a satellite's orbit is attached to the orbit of its parent, so it follows the
+//   revolution but not the rotation
+// - ephemeris_samples>0 adds a precomputed table of that many samples to each revolving body
+inline std::vector<entity> create_bodies( celestial_world& w, scene_graph& scene, const body_desc* bodies, size_t count, uint ephemeris_samples=0 )
 {
-	std::vector<planet_t> planets;
+	std::vector<entity> entities;
+	for( size_t k=0; k < count; k++ )
+	{
+		const body_desc& b = bodies[k];
+		entity e = w.create();
+		int orbit_node = scene.add( b.parent<0||size_t(b.parent)>=k ? -1 : w.orbits[entities[b.parent]].node );
+		scene_trs body; body.scale = vec3(b.planetRadius);
+		int body_node = scene.add( orbit_node, body );
+
+		kepler_orbit orbit( b.revRadius, b.eccentricity, b.revSpeed, radians(b.inclination), radians(b.node), radians(b.periapsis) );
+		w.orbits.add( e, { orbit, orbit_node } );
+		if(ephemeris_samples&&orbit.n!=0) w.ephemerides.add( e ).table.create( orbit, ephemeris_samples );
+		w.spins.add( e, { b.rotSpeed, body_node } );
+		w.transforms.add( e, { body_node } );
+		w.meshes.add( e, { b.planetRadius } );
+		w.colors.add( e, { b.rgb } );
+		entities.push_back(e);
+	}
+	return entities;
+}
 
-	planet_t p;
+//*************************************
+// systems: linear passes over the packed components
+// revolutions from the ephemerides when enabled and present, or from one batched solve of
+// Kepler's equation for the rest
+inline void orbit_system( celestial_world& w, scene_graph& scene, double t, bool use_ephemeris=false )
+{
+	static std::vector<uint> solved; static std::vector<float> M, e, E;
+	solved.clear(); M.clear(); e.clear();
+	for( size_t k=0; k < w.orbits.size(); k++ )
+	{
+		const ephemeris_component* x = use_ephemeris ? w.ephemerides.find(w.orbits.owner[k]) : nullptr;
+		if(x){ scene.edit(w.orbits.data[k].node).translation = x->table.position(t); continue; }
+		const kepler_orbit& o = w.orbits.data[k].orbit;
+		solved.push_back(uint(k)); M.push_back(o.mean_anomaly(t)); e.push_back(o.e);
+	}
+	E.resize(M.size()); kepler_solve( M.data(), e.data(), E.data(), M.size() );
+	for( size_t k=0; k < solved.size(); k++ ){ const orbit_component& o = w.orbits.data[solved[k]]; scene.edit(o.node).translation = o.orbit.position_at(E[k]); }
+}
 
-	planets.emplace_back(sun);
-	planets.emplace_back(mercury);
-	planets.emplace_back(venus);
-	planets.emplace_back(earth);
-	planets.emplace_back(mars);
-	planets.emplace_back(jupiter);
-	planets.emplace_back(saturn);
-	planets.emplace_back(uranus);
-	planets.emplace_back(neptune);
+inline void spin_system( celestial_world& w, scene_graph& scene, double t )
+{
+	for( auto& s : w.spins.data ) scene.edit(s.node).angle = float(fmod(t*s.speed,2.0*PI_D));
+}
 
-	return planets;
+// run after scene_graph::update()
+inline void transform_system( celestial_world& w, const scene_graph& scene, const dvec3& eye )
+{
+	for( auto& x : w.transforms.data ) x.model_matrix = scene.model_matrix( x.node, eye );
 }
 
-#endif
\ No newline at end of file
+#endif
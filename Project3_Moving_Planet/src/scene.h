@@ -0,0 +1,88 @@
+#pragma once
+#ifndef __SCENE_H__
+#define __SCENE_H__
+
+#include "cgmath.h"		// slee's simple math library
+
+//*************************************
+// flat, index-based scene graph
+// - nodes live in parallel arrays; a parent is always added before its children
+//   (parent[k]<k), so one forward pass visits the nodes in topological order
+// - local and world translations are kept in double for camera-relative rendering (see
+//   rte_model_matrix()), and only rotation/scale is in float; a parent's rotation/scale is
+//   applied to the child's translation in double, so orbits compose without rounding
+// - editing a local transform marks the node dirty; update() starts from the first
+//   dirty node and recomputes only the nodes whose local transform or ancestor changed
+struct scene_trs // local transform: translate * rotate * scale
+{
+	dvec3	translation = dvec3(0);
+	vec3	axis = vec3(0,1,0);		// rotation axis
+	float	angle = 0;				// rotation angle in radians
+	vec3	scale = vec3(1);
+
+	// rotate * scale; the translation column is zero
+	mat4x3 linear_matrix() const
+	{
+		mat4x3 m = angle==0 ? mat4x3() : mat4x3::rotate(axis,angle);
+		m._11*=scale.x; m._21*=scale.x; m._31*=scale.x;
+		m._12*=scale.y; m._22*=scale.y; m._32*=scale.y;
+		m._13*=scale.z; m._23*=scale.z; m._33*=scale.z;
+		return m;
+	}
+};
+
+struct scene_graph
+{
+	std::vector<int>		parent;				// parent node, or -1 for roots
+	std::vector<scene_trs>	local;
+	std::vector<mat4x3>		world;				// rotation/scale; the translation column is zero
+	std::vector<dvec3>		world_position;		// translation in double
+	std::vector<uint8_t>	dirty;				// local transform edited since the last update()
+	std::vector<uint8_t>	changed;			// world transform recomputed by the last update()
+
+	size_t size() const { return parent.size(); }
+
+	int add( int parent_index, const scene_trs& trs=scene_trs() )
+	{
+		int k = int(parent.size());
+		if(parent_index>=k){ printf( "%s(): parent %d should be added before node %d\n", __func__, parent_index, k ); parent_index=-1; }
+		parent.push_back(parent_index); local.push_back(trs);
+		world.emplace_back(); world_position.emplace_back(0.0);
+		dirty.push_back(1); changed.push_back(0);
+		first_dirty = min(first_dirty,size_t(k));
+		return k;
+	}
+
+	// editing access to a local transform, which marks the node dirty
+	scene_trs& edit( int k ){ dirty[k]=1; first_dirty=min(first_dirty,size_t(k)); return local[k]; }
+
+	// propagates dirty local transforms to the world transforms; returns the number of recomputed nodes
+	size_t update()
+	{
+		size_t n = size(), recomputed = 0;
+		if(first_changed<first_dirty) memset( &changed[first_changed], 0, min(first_dirty,n)-first_changed );
+		for( size_t k=first_dirty; k < n; k++ )
+		{
+			int p = parent[k];
+			if(!(changed[k]=dirty[k]||(p>=0&&changed[p]))) continue;
+			dirty[k] = 0; recomputed++;
+
+			mat4x3 m = local[k].linear_matrix(); const dvec3& t = local[k].translation;
+			if(p<0){ world_position[k]=t; world[k]=m; continue; }
+			const mat4x3& w = world[p];
+			world_position[k] = world_position[p]+dvec3( w._11*t.x+w._12*t.y+w._13*t.z, w._21*t.x+w._22*t.y+w._23*t.z, w._31*t.x+w._32*t.y+w._33*t.z );
+			world[k] = w*m;
+		}
+		first_changed = min(first_dirty,n); first_dirty = n;
+		return recomputed;
+	}
+
+	// eye-relative model matrix for rendering
+	mat4x3 model_matrix( int k, const dvec3& eye ) const { return rte_model_matrix( world_position[k], world[k], eye ); }
+
+protected:
+	size_t	first_dirty = 0;	// no dirty node before this
+	size_t	first_changed = 0;	// no changed flag set before this
+};
+
+#endif // __SCENE_H__
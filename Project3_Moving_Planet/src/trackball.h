@@ -8,25 +8,30 @@ struct trackball
 	float	scale;			// controls how much rotation is applied
 	float	move;			// controls the movement of panning and zooming
 	mat4	view_matrix0;	// initial view matrix
+	dvec3	eye0;			// initial eye position in double
 	vec2	m0;				// the last mouse position
 	int		button = 0;
 	int		mods = 0;
 
 	trackball(float rot_scale = 1.0f, float move_scale = 100.0f) : scale(rot_scale), move(move_scale) {}
 	bool is_tracking() const { return b_tracking; }
-	void begin(const mat4& view_matrix, vec2 m);
+	void begin(const mat4& view_matrix, const dvec3& eye, vec2 m);
 	void end() { b_tracking = false; }
-	mat4 update(vec2 m) const;
-	mat4 update_pan(vec2 m) const;
-	mat4 update_zoom(vec2 m) const;
+
+	// each returns the view matrix, and moves the eye in double alongside
+	// - only the rotation of the view matrix is used for rendering (see rte_view_matrix());
+	//   its float translation would round the eye at large distances
+	mat4 update(vec2 m, dvec3& eye) const;
+	mat4 update_pan(vec2 m, dvec3& eye) const;
+	mat4 update_zoom(vec2 m, dvec3& eye) const;
 };
 
 struct camera
 {
-	vec3	eye = vec3(0, 100, 200);//camera ġ
+	dvec3	eye = dvec3(0, 100, 200);//camera ġ
 	vec3	at = vec3(0, 0, 0);//target
 	vec3	up = vec3(0, 1, 0);//ٸ ̽
-	mat4	view_matrix = mat4::look_at(eye, at, up);
+	mat4	view_matrix = mat4::look_at(vec3(eye), at, up);	// the eye is kept in double above
 
 	float	fovy = PI / 4.0f; // must be in radian
 	float	aspect_ratio = 0.0f;
@@ -37,19 +42,20 @@ struct camera
 
 camera	cam;
 
-inline void trackball::begin(const mat4& view_matrix, vec2 m)
+inline void trackball::begin(const mat4& view_matrix, const dvec3& eye, vec2 m)
 {
 	b_tracking = true;			// enable trackball tracking
 	m0 = m;			  			// save current mouse position
 	view_matrix0 = view_matrix;	// save current view matrix
+	eye0 = eye;					// save current eye position
 }
 
-inline mat4 trackball::update(vec2 m) const
+inline mat4 trackball::update(vec2 m, dvec3& eye) const
 {
 	// project a 2D mouse position to a unit sphere
 	static const vec3 p0 = vec3(0, 0, 1.0f);	// reference position on sphere
 	vec3 p1 = vec3(m - m0, 0);					// displacement
-	if (!b_tracking || length(p1) < 0.0001f) return view_matrix0;		// ignore subtle movement
+	if (!b_tracking || length(p1) < 0.0001f) { eye = eye0; return view_matrix0; }	// ignore subtle movement
 	p1 *= scale;														// apply rotation scale
 	p1 = vec3(p1.x, p1.y, sqrtf(max(0, 1.0f - length2(p1)))).normalize();	// back-project z=0 onto the unit sphere
 
@@ -61,30 +67,34 @@ inline mat4 trackball::update(vec2 m) const
 	float theta = asin(min(v.length(), 1.0f));
 
 	// resulting view matrix, which first applies
-	// trackball rotation in the world space
+	// trackball rotation in the world space; the eye turns the other way about the origin
+	dvec4 e = dmat4::rotate(dvec3(v.normalize()), -double(theta)) * dvec4(eye0, 1.0);
+	eye = dvec3(e.x, e.y, e.z);
 	return view_matrix0 * mat4::rotate(v.normalize(), theta);
 }
 
-inline mat4 trackball::update_pan(vec2 m) const
+inline mat4 trackball::update_pan(vec2 m, dvec3& eye) const
 {
 	// project a 2D mouse position to a unit sphere
 	//static const vec3 p0 = vec3(0);	// reference position on sphere
 	vec3 u = vec3(view_matrix0[0], view_matrix0[1], view_matrix0[2]);
 	vec3 v = vec3(view_matrix0[4], view_matrix0[5], view_matrix0[6]);
 	vec2 dis = vec2(m - m0) * move;										// displacement
-	if (!b_tracking || length(dis) < 0.0001f) return view_matrix0;		// ignore subtle movement												
+	if (!b_tracking || length(dis) < 0.0001f) { eye = eye0; return view_matrix0; }	// ignore subtle movement
 
 	// resulting view matrix, which first applies
 	// trackball rotation in the world space
+	eye = eye0 - dvec3(u * dis.x + v * dis.y);
 	return view_matrix0 * mat4::translate(u * dis.x + v * dis.y);
 }
 
-inline mat4 trackball::update_zoom(vec2 m) const
+inline mat4 trackball::update_zoom(vec2 m, dvec3& eye) const
 {
 	vec3 n = vec3(view_matrix0[8], view_matrix0[9], view_matrix0[10]);
 	float dis = (m - m0).y * move;
-	if (!b_tracking || abs(dis) < 0.0001f) return view_matrix0;			// ignore subtle movement
+	if (!b_tracking || abs(dis) < 0.0001f) { eye = eye0; return view_matrix0; }	// ignore subtle movement
 
+	eye = eye0 - dvec3(n * dis);
 	return view_matrix0 * mat4::translate(n * dis);
 }
 
@@ -0,0 +1,140 @@
+#pragma once
+#ifndef __WORKPOOL_H__
+#define __WORKPOOL_H__
+
+#include <atomic>
+#include <condition_variable>	// include before cgmath.h, which defines min/max macros
+#include <functional>
+#include <thread>
+#include <vector>
+#include "cgmath.h"		// slee's simple math library
+
+//*************************************
+// work-stealing pool of threads for parallel loops whose iterations vary in cost
+// - parallel_for() cuts [0,n) into chunks of grain iterations, and hands every thread
+//   (the caller included) a contiguous range of chunks
+// - a thread takes chunks from the front of its own range; when empty, it steals the
+//   back half of another thread's range and continues there, so busy ranges are split
+//   only on demand and the chunks a thread runs stay mostly contiguous
+// - a range is packed into one 64-bit atomic (front | back<<32), so taking and stealing
+//   are single compare-and-swaps; the value holds the whole state, so ABA is harmless
+// - parallel_for() rewrites the ranges only while no worker is inside run(): a worker
+//   may still be leaving the previous call, and its refill would clobber the new chunks
+// - parallel_for() is not reentrant: do not call it from inside a job
+struct work_pool
+{
+	work_pool( uint threads=std::thread::hardware_concurrency() )
+	{
+		threads = threads ? threads : 1;
+		ranges = std::vector<range>(threads);
+		for( uint k=1; k < threads; k++ ) workers.emplace_back( [this,k](){ worker_main(k); } );
+	}
+
+	~work_pool()
+	{
+		{ std::lock_guard<std::mutex> lock(mutex); quit = true; }
+		wake.notify_all();
+		for( auto& t : workers ) t.join();
+	}
+
+	uint size() const { return uint(ranges.size()); }
+
+	// calls f(begin,end) for subranges covering [0,n); returns when all of them are done
+	void parallel_for( size_t n, size_t grain, const std::function<void(size_t,size_t)>& f )
+	{
+		if(n==0) return;
+		grain = grain ? grain : 1;
+		size_t chunks = (n+grain-1)/grain;
+		if(workers.empty()||chunks==1){ f(0,n); return; }
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);	// keeps workers from entering run() until the new generation
+			while(active.load()) std::this_thread::yield();	// workers still leaving run() of the previous call
+			job = &f; job_size = n; job_grain = grain;
+			remaining.store( chunks );
+			uint t = size();
+			for( uint k=0; k < t; k++ ) ranges[k].value.store( pack( uint(chunks*k/t), uint(chunks*(k+1)/t) ) );
+			generation++;
+		}
+		wake.notify_all();
+
+		run( 0 );
+		while(remaining.load()) std::this_thread::yield();	// chunks still running on other threads
+	}
+
+protected:
+	struct alignas(64) range { std::atomic<uint64_t> value{0}; };	// one per cache line
+
+	std::vector<range>			ranges;		// chunks to run of each thread; 0 is the caller
+	std::vector<std::thread>	workers;
+	std::mutex					mutex;
+	std::condition_variable		wake;
+	uint64_t					generation = 0;	// bumped for each parallel_for()
+	bool						quit = false;
+	const std::function<void(size_t,size_t)>* job = nullptr;
+	size_t						job_size = 0, job_grain = 1;
+	std::atomic<size_t>			remaining{0};	// chunks not finished yet
+	std::atomic<uint>			active{0};		// workers inside run()
+
+	static uint64_t pack( uint front, uint back ){ return uint64_t(front)|uint64_t(back)<<32; }
+
+	// takes the front chunk of a range
+	static bool pop( range& r, uint& chunk )
+	{
+		uint64_t v = r.value.load();
+		for(;;)
+		{
+			uint front = uint(v), back = uint(v>>32); if(front>=back) return false;
+			if(r.value.compare_exchange_weak( v, pack(front+1,back) )){ chunk = front; return true; }
+		}
+	}
+
+	// takes the back half of a range, rounded up so that a single chunk can be stolen
+	static bool steal( range& r, uint& front, uint& back )
+	{
+		uint64_t v = r.value.load();
+		for(;;)
+		{
+			uint f = uint(v), b = uint(v>>32); if(f>=b) return false;
+			uint split = b-(b-f+1)/2;
+			if(r.value.compare_exchange_weak( v, pack(f,split) )){ front = split; back = b; return true; }
+		}
+	}
+
+	void run( uint k )
+	{
+		uint n = size(), chunk, front, back;
+		for(;;)
+		{
+			while(pop( ranges[k], chunk ))
+			{
+				size_t begin = size_t(chunk)*job_grain;
+				(*job)( begin, min(begin+job_grain,job_size) );
+				remaining.fetch_sub(1);
+			}
+			bool stolen = false;
+			for( uint i=1; i < n && !stolen && remaining.load(); i++ ) stolen = steal( ranges[(k+i)%n], front, back );
+			if(!stolen) return;
+			ranges[k].value.store( pack(front,back) );	// others only shrink a range, and parallel_for() waits for active workers
+		}
+	}
+
+	void worker_main( uint k )
+	{
+		uint64_t seen = 0;
+		for(;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait( lock, [&](){ return quit||generation!=seen; } );
+				if(quit) return;
+				seen = generation;
+				active++;
+			}
+			run( k );
+			active--;
+		}
+	}
+};
+
+#endif // __WORKPOOL_H__